@@ -0,0 +1,77 @@
+/**
+	\file alignedallocator.h
+	\brief Header and code for AlignedAllocator class
+*/
+
+#ifndef ALIGNEDALLOCATOR_H_INCLUDED
+#define ALIGNEDALLOCATOR_H_INCLUDED
+#include <cstddef>
+#include <limits>
+#include <new>
+
+/**
+	\brief Size of a cache line in bytes on the targeted hardware
+*/
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/**
+	\class AlignedAllocator
+	\brief Allocator returning storage aligned to Alignment bytes, used for matrix buffers
+*/
+template <typename T, std::size_t Alignment = CACHE_LINE_SIZE>
+class AlignedAllocator{
+
+public:
+	using value_type = T;
+
+	/**
+		\brief Rebinds the allocator to another value type with the same alignment
+	*/
+	template <typename U>
+	struct rebind{
+		using other = AlignedAllocator<U, Alignment>;
+	};
+
+	/**
+		\brief Empty constructor
+	*/
+	AlignedAllocator() noexcept = default;
+
+	/**
+		\brief Converting constructor from an allocator of another value type
+	*/
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept{}
+
+	/**
+		\brief Allocates aligned storage for count objects
+		\param Number of objects
+		\return Pointer to uninitialized storage
+		\throw std::bad_array_new_length if the size overflows
+	*/
+	T* allocate(std::size_t count){
+		if(count > std::numeric_limits<std::size_t>::max() / sizeof(T))
+			throw std::bad_array_new_length();
+		return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+	}
+
+	/**
+		\brief Releases storage returned by allocate
+		\param Pointer to release
+	*/
+	void deallocate(T* p, std::size_t) noexcept{
+		::operator delete(p, std::align_val_t(Alignment));
+	}
+};
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&){
+	return true;
+}
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&){
+	return false;
+}
+
+#endif // ALIGNEDALLOCATOR_H_INCLUDED
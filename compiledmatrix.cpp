@@ -0,0 +1,289 @@
+/**
+	\file compiledmatrix.cpp
+	\brief Code for CompiledMatrix class
+*/
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include "compiledmatrix.h"
+#include "threadpool.h"
+
+namespace{
+
+/**
+	\brief Register reference made while compiling, before the number of variables and constants is known
+*/
+struct Operand{
+	enum Kind : char{
+		Variable,
+		Constant,
+		Result
+	};
+	Kind kind;
+	int index;
+};
+
+/**
+	\brief Compiled node with the size of its tree
+*/
+struct CompiledNode{
+	Operand operand;
+	std::uint64_t size;
+};
+
+/**
+	\brief Sum of tree sizes, saturating instead of wrapping around
+*/
+std::uint64_t addSizes(std::uint64_t a, std::uint64_t b){
+	return a > std::numeric_limits<std::uint64_t>::max() - b ? std::numeric_limits<std::uint64_t>::max() : a + b;
+}
+
+}
+
+CompiledMatrix::CompiledMatrix(const SymbolicSquareMatrix& m):n{m.getSize()},distinctNodes{0},treeNodes{0}{
+	std::unordered_map<const Element*, CompiledNode> compiled;
+	std::unordered_map<char, int> variableIndex;
+	std::unordered_map<int, int> constantIndex;
+	std::vector<std::pair<Operand, Operand>> operands;
+	std::vector<Operand> elementOperands;
+	elementOperands.reserve(static_cast<std::size_t>(n)*n);
+
+	auto constant = [&](int value){
+		auto inserted = constantIndex.emplace(value, static_cast<int>(constants.size()));
+		if(inserted.second)
+			constants.push_back(value);
+		return Operand{Operand::Constant, inserted.first->second};
+	};
+	auto leaf = [](Operand o){
+		return CompiledNode{o, 1};
+	};
+
+	// Post-order walk with an explicit stack, the trees of large products are too deep to recurse
+	std::vector<std::pair<const Element*, bool>> stack;
+	for (int i = 0; i < n; ++i){
+		for (int j = 0; j < n; ++j){
+			stack.emplace_back(&m.getElement(i, j), false);
+			while(!stack.empty()){
+				const Element* node = stack.back().first;
+				const bool expanded = stack.back().second;
+				if(compiled.count(node)){
+					stack.pop_back();
+					continue;
+				}
+
+				if(const CompositeElement* composite = dynamic_cast<const CompositeElement*>(node)){
+					if(!expanded){
+						stack.back().second = true;
+						stack.emplace_back(composite->getRight().get(), false);
+						stack.emplace_back(composite->getLeft().get(), false);
+						continue;
+					}
+					const CompiledNode& leftNode = compiled.at(composite->getLeft().get());
+					const CompiledNode& rightNode = compiled.at(composite->getRight().get());
+					const Operand left = leftNode.operand, right = rightNode.operand;
+					const std::uint64_t size = addSizes(addSizes(leftNode.size, rightNode.size), 1);
+					if(left.kind == Operand::Constant && right.kind == Operand::Constant){
+						compiled.emplace(node, CompiledNode{constant(applyOp(composite->getOp(), constants[left.index], constants[right.index])), size});
+					}else{
+						compiled.emplace(node, CompiledNode{Operand{Operand::Result, static_cast<int>(code.size())}, size});
+						code.push_back(Instruction{composite->getOp(), 0, 0});
+						operands.emplace_back(left, right);
+					}
+				}else if(const VariableElement* variable = dynamic_cast<const VariableElement*>(node)){
+					auto inserted = variableIndex.emplace(variable->getVal(), static_cast<int>(variables.size()));
+					if(inserted.second){
+						variables.push_back(variable->getVal());
+						referenced.set(static_cast<unsigned char>(variable->getVal()));
+					}
+					compiled.emplace(node, leaf(Operand{Operand::Variable, inserted.first->second}));
+				}else{
+					compiled.emplace(node, leaf(constant(node->evaluate(DenseValuation()))));
+				}
+				stack.pop_back();
+			}
+			const CompiledNode& root = compiled.at(&m.getElement(i, j));
+			elementOperands.push_back(root.operand);
+			treeNodes = addSizes(treeNodes, root.size);
+		}
+	}
+
+	distinctNodes = compiled.size();
+
+	const int variableCount = static_cast<int>(variables.size());
+	const int resultBase = variableCount + static_cast<int>(constants.size());
+	auto reg = [&](const Operand& o){
+		switch(o.kind){
+			case Operand::Variable:
+				return o.index;
+			case Operand::Constant:
+				return variableCount + o.index;
+			case Operand::Result:
+				break;
+		}
+		return resultBase + o.index;
+	};
+
+	for (std::size_t k = 0; k < code.size(); ++k){
+		code[k].left = reg(operands[k].first);
+		code[k].right = reg(operands[k].second);
+	}
+	outputs.reserve(elementOperands.size());
+	for (const Operand& o : elementOperands)
+		outputs.push_back(reg(o));
+}
+
+ConcreteSquareMatrix CompiledMatrix::evaluate(const int* values) const{
+	// Registers are unsigned so that the arithmetic wraps like applyOp
+	thread_local std::vector<unsigned int> registers;
+	registers.resize(getRegisterCount());
+
+	unsigned int* r = registers.data();
+	for (std::size_t v = 0; v < variables.size(); ++v)
+		*r++ = static_cast<unsigned int>(values[v]);
+	for (int c : constants)
+		*r++ = static_cast<unsigned int>(c);
+
+	const unsigned int* in = registers.data();
+	for (const Instruction& instruction : code){
+		const unsigned int a = in[instruction.left], b = in[instruction.right];
+		switch(instruction.op){
+			case OpCode::Add:
+				*r = a + b;
+				break;
+			case OpCode::Subtract:
+				*r = a - b;
+				break;
+			case OpCode::Multiply:
+				*r = a * b;
+				break;
+		}
+		++r;
+	}
+
+	ConcreteSquareMatrix result(n);
+	int* out = result.data();
+	for (int o : outputs)
+		*out++ = static_cast<int>(in[o]);
+	return result;
+}
+
+ConcreteSquareMatrix CompiledMatrix::evaluate(const DenseValuation& val) const{
+	const std::bitset<256> missing = referenced & ~val.getPresent();
+	if(missing.any())
+		throw std::out_of_range(unmappedMessage(missing));
+
+	std::vector<int> values;
+	values.reserve(variables.size());
+	for (char name : variables)
+		values.push_back(val[name]);
+	return evaluate(values.data());
+}
+
+template <typename Target>
+void CompiledMatrix::evaluateBlocks(std::size_t count, const int* values, const Target& target) const{
+	const std::size_t size = static_cast<std::size_t>(n)*n;
+	const std::size_t blocks = (count + BATCH_BLOCK - 1) / BATCH_BLOCK;
+
+	auto block = [&](std::size_t first){
+		const std::size_t width = std::min(BATCH_BLOCK, count - first);
+		// Register k of the block is the row [k*BATCH_BLOCK, k*BATCH_BLOCK+width)
+		thread_local std::vector<unsigned int> registers;
+		registers.resize(getRegisterCount()*BATCH_BLOCK);
+
+		unsigned int* r = registers.data();
+		for (std::size_t v = 0; v < variables.size(); ++v, r += BATCH_BLOCK){
+			const int* column = values + v*count + first;
+			for (std::size_t b = 0; b < width; ++b)
+				r[b] = static_cast<unsigned int>(column[b]);
+		}
+		for (int c : constants){
+			std::fill(r, r + width, static_cast<unsigned int>(c));
+			r += BATCH_BLOCK;
+		}
+
+		const unsigned int* in = registers.data();
+		for (const Instruction& instruction : code){
+			const unsigned int* __restrict a = in + static_cast<std::size_t>(instruction.left)*BATCH_BLOCK;
+			const unsigned int* __restrict c = in + static_cast<std::size_t>(instruction.right)*BATCH_BLOCK;
+			unsigned int* __restrict result = r;
+			switch(instruction.op){
+				case OpCode::Add:
+					for (std::size_t b = 0; b < width; ++b)
+						result[b] = a[b] + c[b];
+					break;
+				case OpCode::Subtract:
+					for (std::size_t b = 0; b < width; ++b)
+						result[b] = a[b] - c[b];
+					break;
+				case OpCode::Multiply:
+					for (std::size_t b = 0; b < width; ++b)
+						result[b] = a[b] * c[b];
+					break;
+			}
+			r += BATCH_BLOCK;
+		}
+
+		int* results[BATCH_BLOCK];
+		for (std::size_t b = 0; b < width; ++b)
+			results[b] = target(first + b);
+		for (std::size_t e = 0; e < size; ++e){
+			const unsigned int* row = in + static_cast<std::size_t>(outputs[e])*BATCH_BLOCK;
+			for (std::size_t b = 0; b < width; ++b)
+				results[b][e] = static_cast<int>(row[b]);
+		}
+	};
+
+	ThreadPool& pool = ThreadPool::global();
+	if(blocks < 2 || pool.getThreadCount() == 1){
+		for (std::size_t k = 0; k < blocks; ++k)
+			block(k*BATCH_BLOCK);
+		return;
+	}
+	pool.parallelFor(static_cast<int>(blocks), [&](int k){
+		block(static_cast<std::size_t>(k)*BATCH_BLOCK);
+	});
+}
+
+void CompiledMatrix::evaluateBatch(std::size_t count, const int* values, int* out) const{
+	const std::size_t size = static_cast<std::size_t>(n)*n;
+	evaluateBlocks(count, values, [out, size](std::size_t b){
+		return out + b*size;
+	});
+}
+
+std::vector<ConcreteSquareMatrix> CompiledMatrix::evaluateBatch(const ValuationBatch& vals) const{
+	std::bitset<256> missing = referenced;
+	for (const auto& entry : vals)
+		missing.reset(static_cast<unsigned char>(entry.first));
+	if(missing.any())
+		throw std::out_of_range(unmappedMessage(missing));
+
+	// the batch size comes from the sequences themselves, even for a matrix without variables
+	if(vals.empty())
+		throw std::invalid_argument("Empty batch, number of valuations unknown");
+	const std::size_t count = vals.begin()->second.size();
+	for (const auto& entry : vals){
+		if(entry.second.size() != count)
+			throw std::invalid_argument("Valuations of different lengths");
+	}
+
+	std::vector<int> values;
+	values.reserve(variables.size()*count);
+	for (char name : variables){
+		const std::vector<int>& column = vals.at(name);
+		values.insert(values.end(), column.begin(), column.end());
+	}
+
+	// each block writes straight into the result matrices, no intermediate tensor
+	std::vector<ConcreteSquareMatrix> results;
+	results.reserve(count);
+	for (std::size_t b = 0; b < count; ++b)
+		results.emplace_back(n);
+	evaluateBlocks(count, values.data(), [&results](std::size_t b){
+		return results[b].data();
+	});
+	return results;
+}
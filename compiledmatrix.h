@@ -0,0 +1,221 @@
+/**
+	\file compiledmatrix.h
+	\brief Header for CompiledMatrix class
+*/
+
+#ifndef COMPILEDMATRIX_H_INCLUDED
+#define COMPILEDMATRIX_H_INCLUDED
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "compositeelement.h"
+#include "concretematrix.h"
+#include "elementarymatrix.h"
+#include "valuation.h"
+
+/**
+	\class CompiledMatrix
+	\brief A SymbolicSquareMatrix lowered into a flat register program, for evaluating it against many valuations
+
+	The register file holds the variables first, then the constants, then one register per instruction.
+	Every distinct node of the element trees becomes one register, so a subexpression shared between
+	elements is computed once per evaluation. Operations on two constants are folded while compiling.
+	getTreeNodeCount and getDistinctNodeCount tell how much evaluating the elements as independent
+	trees would repeat.
+	Evaluation is a single loop over the instructions, without virtual calls or map lookups. Batch
+	evaluation runs every instruction across a block of valuations at a time, so the loop over the
+	block vectorizes and the dispatch is paid once per block instead of once per valuation.
+*/
+class CompiledMatrix{
+
+public:
+	/**
+		\brief One operation, the result goes to the register after the constants with the same index
+	*/
+	struct Instruction{
+		OpCode op;
+		int left;
+		int right;
+	};
+
+	/**
+		\brief Number of valuations evaluated together, each register holds one value per valuation
+	*/
+	static constexpr std::size_t BATCH_BLOCK = 64;
+
+private:
+	/**
+		\brief Integer to store matrix dimension (n x n)
+	*/
+	int n;
+	/**
+		\brief Variable name of each variable register
+	*/
+	std::vector<char> variables;
+	/**
+		\brief Set bit for every variable name in variables
+	*/
+	std::bitset<256> referenced;
+	/**
+		\brief Values of the constant registers
+	*/
+	std::vector<int> constants;
+	/**
+		\brief Program in evaluation order
+	*/
+	std::vector<Instruction> code;
+	/**
+		\brief Register holding element (i,j) at i*n+j
+	*/
+	std::vector<int> outputs;
+	/**
+		\brief Distinct nodes found in the element trees
+	*/
+	std::size_t distinctNodes;
+	/**
+		\brief Nodes of the element trees counted as if nothing was shared, saturates at the maximum
+	*/
+	std::uint64_t treeNodes;
+
+	/**
+		\brief Evaluates blocks of valuations, the n*n results of valuation b are written to target(b)
+	*/
+	template <typename Target>
+	void evaluateBlocks(std::size_t count, const int* values, const Target& target) const;
+
+public:
+	/**
+		\brief Empty constructor
+	*/
+	CompiledMatrix():n{0},distinctNodes{0},treeNodes{0}{}
+
+	/**
+		\brief Compiles a symbolic matrix
+		\param SymbolicSquareMatrix to compile
+	*/
+	explicit CompiledMatrix(const SymbolicSquareMatrix& m);
+
+	/**
+		\brief Method to get matrix dimension
+		\return Dimension n of the n x n matrix
+	*/
+	int getSize() const{
+		return n;
+	}
+
+	/**
+		\brief Method to get the variables the program reads, in register order
+		\return Variable names
+	*/
+	const std::vector<char>& getVariables() const{
+		return variables;
+	}
+
+	/**
+		\brief Method to get the set of variables the program reads
+		\return Bit c is set if variable c is read
+	*/
+	const std::bitset<256>& getReferencedVariables() const{
+		return referenced;
+	}
+
+	/**
+		\brief Method to get the constant registers
+		\return Values in register order, following the variables
+	*/
+	const std::vector<int>& getConstants() const{
+		return constants;
+	}
+
+	/**
+		\brief Method to get the program
+		\return Instructions in evaluation order, following the variables and constants in the register file
+	*/
+	const std::vector<Instruction>& getCode() const{
+		return code;
+	}
+
+	/**
+		\brief Method to get the register holding each element
+		\return Register of element (i,j) at i*n+j
+	*/
+	const std::vector<int>& getOutputs() const{
+		return outputs;
+	}
+
+	/**
+		\brief Method to get the number of instructions, the distinct operations left after folding
+		\return Instruction count
+	*/
+	std::size_t getInstructionCount() const{
+		return code.size();
+	}
+
+	/**
+		\brief Method to get the number of distinct nodes, each is evaluated at most once
+		\return Distinct node count
+	*/
+	std::size_t getDistinctNodeCount() const{
+		return distinctNodes;
+	}
+
+	/**
+		\brief Method to get the size of the elements as independent trees, what a tree walk evaluates
+		\return Node count with repetitions, saturated at the maximum of std::uint64_t
+	*/
+	std::uint64_t getTreeNodeCount() const{
+		return treeNodes;
+	}
+
+	/**
+		\brief Method to get the number of node evaluations sharing saves
+		\return Tree nodes minus distinct nodes
+	*/
+	std::uint64_t getEliminatedCount() const{
+		return treeNodes - distinctNodes;
+	}
+
+	/**
+		\brief Method to get the number of registers
+		\return Variables, constants and instructions together
+	*/
+	std::size_t getRegisterCount() const{
+		return variables.size() + constants.size() + code.size();
+	}
+
+	/**
+		\brief Evaluates the program with the variable values given in register order
+		\param Value of each variable, as many as getVariables() has
+		\return Resulting ConcreteSquareMatrix
+	*/
+	ConcreteSquareMatrix evaluate(const int* values) const;
+
+	/**
+		\brief Evaluates the program according to a valuation map, same result as SymbolicSquareMatrix::evaluate
+		\param Valuation to be used, a Valuation map converts implicitly
+		\return Resulting ConcreteSquareMatrix
+		\throw std::out_of_range naming every variable of the matrix that is not mapped
+	*/
+	ConcreteSquareMatrix evaluate(const DenseValuation& val) const;
+
+	/**
+		\brief Evaluates the program for many valuations, blocks of them are split across ThreadPool::global()
+		\param Number of valuations
+		\param Variable values in register order, value of variable v in valuation b at v*count+b
+		\param Output tensor of count*n*n values, element (i,j) of valuation b at (b*n+i)*n+j
+	*/
+	void evaluateBatch(std::size_t count, const int* values, int* out) const;
+
+	/**
+		\brief Evaluates the program for many valuations
+		\param Valuations to be used, every supplied variable must have the same number of values,
+		which is the batch size also for a matrix without variables
+		\return Resulting ConcreteSquareMatrix of every valuation
+		\throw std::out_of_range naming every variable of the matrix that is not mapped
+		\throw std::invalid_argument if the supplied variables have different numbers of values, or if none are supplied
+	*/
+	std::vector<ConcreteSquareMatrix> evaluateBatch(const ValuationBatch& vals) const;
+};
+
+#endif // COMPILEDMATRIX_H_INCLUDED
@@ -7,29 +7,29 @@
 #include <string>
 #include <sstream>
 
-CompositeElement::CompositeElement(const Element& e1, const Element& e2,
-								const std::function<int(int,int)>& op, char opc){
-	oprnd1 = std::unique_ptr<Element>(e1.clone());
-	oprnd2 = std::unique_ptr<Element>(e2.clone());
-	op_fun = op;
-	op_ch = opc;
+CompositeElement::CompositeElement(const Element& e1, const Element& e2, OpCode opc){
+	oprnd1 = std::shared_ptr<const Element>(e1.clone());
+	oprnd2 = std::shared_ptr<const Element>(e2.clone());
+	op = opc;
 
 }
 
+CompositeElement::CompositeElement(std::shared_ptr<const Element> e1, std::shared_ptr<const Element> e2, OpCode opc){
+	oprnd1 = std::move(e1);
+	oprnd2 = std::move(e2);
+	op = opc;
+}
+
 CompositeElement::CompositeElement(const CompositeElement& e){
-	oprnd1 = std::unique_ptr<Element>(e.oprnd1->clone());
-	oprnd2 = std::unique_ptr<Element>(e.oprnd2->clone());
-	op_fun = e.op_fun;
-	op_ch = e.op_ch;
+	oprnd1 = e.oprnd1;
+	oprnd2 = e.oprnd2;
+	op = e.op;
 }
 
 CompositeElement& CompositeElement::operator=(const CompositeElement& e){
-	CompositeElement tempcopy(e);
-	
-	oprnd1 = std::move(tempcopy.oprnd1);
-	oprnd2 = std::move(tempcopy.oprnd2);
-	op_fun = tempcopy.op_fun;
-	op_ch = tempcopy.op_ch;
+	oprnd1 = e.oprnd1;
+	oprnd2 = e.oprnd2;
+	op = e.op;
 
 	return *this;
 }
@@ -41,11 +41,11 @@ Element* CompositeElement::clone() const{
 std::string CompositeElement::toString() const{
 	std::stringstream strm;
 	strm << "(" << oprnd1->toString();
-	strm << op_ch;
+	strm << static_cast<char>(op);
 	strm << oprnd2->toString() << ")";
 	return strm.str();
 }
 
-int CompositeElement::evaluate(const Valuation& val) const{
-	return op_fun(oprnd1->evaluate(val),oprnd2->evaluate(val));
+int CompositeElement::evaluate(const DenseValuation& val) const{
+	return applyOp(op, oprnd1->evaluate(val), oprnd2->evaluate(val));
 }
\ No newline at end of file
@@ -5,48 +5,80 @@
 
 #ifndef COMPOSITEELEMENT_H_INCLUDED
 #define COMPOSITEELEMENT_H_INCLUDED
-#include <functional>
 #include "element.h"
 #include "valuation.h"
 #include <string>
-#include <functional>
 #include <memory>
 
+/**
+	\brief Operation of a CompositeElement, the value is the character printed by toString
+*/
+enum class OpCode : char{
+	Add = '+',
+	Subtract = '-',
+	Multiply = '*'
+};
+
+/**
+	\brief Applies an operation to two values, wrapping on overflow like IntElement arithmetic
+	\param Operation
+	\param First value
+	\param Second value
+	\return Result of the operation
+*/
+inline int applyOp(OpCode op, int a, int b){
+	const unsigned int x = static_cast<unsigned int>(a), y = static_cast<unsigned int>(b);
+	switch(op){
+		case OpCode::Add:
+			return static_cast<int>(x + y);
+		case OpCode::Subtract:
+			return static_cast<int>(x - y);
+		case OpCode::Multiply:
+			return static_cast<int>(x * y);
+	}
+	return 0;
+}
+
 /**
 	\class CompositeElement
 	\brief A composite class for element
+
+	Nodes are immutable once built, so operands are shared instead of cloned: copying a
+	CompositeElement, or using one as an operand of several others, copies two pointers.
 */
 class CompositeElement : public Element{
 
 private:
 	/**
-		\brief First Element operand uniquepointer
+		\brief First Element operand, shared with every other node using it
 	*/	
-	std::unique_ptr<Element> oprnd1;
-	/**
-		\brief Second Element operand uniquepointer
-	*/
-	std::unique_ptr<Element> oprnd2;
+	std::shared_ptr<const Element> oprnd1;
 	/**
-		\brief std::function op_fun used in math operations, two Int parameters, returns int
+		\brief Second Element operand, shared with every other node using it
 	*/
-	std::function<int(int,int)> op_fun;
+	std::shared_ptr<const Element> oprnd2;
 	/**
-		\brief Char indicating mathematical operation
+		\brief Operation applied to the operands
 	*/
-	char op_ch;
+	OpCode op;
 
 public:
 	/**
 		\brief Parametric constructor
 		\param First Element
 		\param Second Element
-		\param Function to be used
-		\param Char indicating mathematical operation
+		\param Operation
 	*/
-	CompositeElement(const Element& e1, const Element& e2, const std::function<int(int,int)>& op, char opc);
+	CompositeElement(const Element& e1, const Element& e2, OpCode opc);
 	/**
-		\brief Copy constructor
+		\brief Parametric constructor sharing the operands instead of cloning them
+		\param First Element
+		\param Second Element
+		\param Operation
+	*/
+	CompositeElement(std::shared_ptr<const Element> e1, std::shared_ptr<const Element> e2, OpCode opc);
+	/**
+		\brief Copy constructor, the operands are shared
 		\param CompositeElement to copy
 	*/
 	CompositeElement(const CompositeElement& e);
@@ -61,7 +93,7 @@ public:
 	*/
 	virtual ~CompositeElement() = default;
 	/**
-		\brief Method to clone CompositeElement
+		\brief Method to clone CompositeElement, the operands are shared
 		\return Retuns pointer to cloned CompositeElement
 	*/
 	virtual Element* clone() const override;
@@ -73,9 +105,30 @@ public:
 	/**
 		\brief Evaluates according to valuation map
 		\param Used valuation map
-		\return Returns op_fun(oprnd1->evaluate(val),oprmnd2->evaluate(val))
+		\return Returns applyOp(op, oprnd1->evaluate(val), oprnd2->evaluate(val))
+	*/
+	virtual int evaluate(const DenseValuation& val) const override;
+	/**
+		\brief Method to get the operation
+		\return Operation
+	*/
+	OpCode getOp() const{
+		return op;
+	}
+	/**
+		\brief Method to get the first operand
+		\return First operand
+	*/
+	const std::shared_ptr<const Element>& getLeft() const{
+		return oprnd1;
+	}
+	/**
+		\brief Method to get the second operand
+		\return Second operand
 	*/
-	virtual int evaluate(const Valuation& val) const override;
+	const std::shared_ptr<const Element>& getRight() const{
+		return oprnd2;
+	}
 };
 
 #endif // COMPOSITEELEMENT_H_INCLUDED
\ No newline at end of file
@@ -0,0 +1,144 @@
+/**
+	\file concretematrix.cpp
+	\brief Code for ConcreteSquareMatrix and Concrete64SquareMatrix
+*/
+
+#include <sstream>
+#include <stdexcept>
+#include "concretematrix.h"
+#include "matrixparser.h"
+
+template <typename Scalar>
+ElementarySquareMatrix<TElement<Scalar>>::ElementarySquareMatrix(const std::string& str_m){
+	n = tokenizeMatrix(str_m, [this](const MatrixToken& token){
+		// the first row gives the dimension, the buffer is sized once
+		if(token.endsRow && token.row == 0)
+			elements.reserve(static_cast<std::size_t>(token.column + 1)*(token.column + 1));
+		elements.push_back(tokenValue<Scalar>(token));
+	});
+}
+
+template <typename Scalar>
+ElementarySquareMatrix<TElement<Scalar>> ElementarySquareMatrix<TElement<Scalar>>::transpose() const&{
+	ElementarySquareMatrix mtemp(n);
+	transposeKernel(n, elements.data(), mtemp.elements.data());
+	return mtemp;
+}
+
+template <typename Scalar>
+ElementarySquareMatrix<TElement<Scalar>> ElementarySquareMatrix<TElement<Scalar>>::transpose() &&{
+	transposeInPlace();
+	return std::move(*this);
+}
+
+template <typename Scalar>
+ElementarySquareMatrix<TElement<Scalar>>& ElementarySquareMatrix<TElement<Scalar>>::transposeInPlace(){
+	transposeInPlaceKernel(n, elements.data());
+	return *this;
+}
+
+template <typename Scalar>
+std::string ElementarySquareMatrix<TElement<Scalar>>::toString() const{
+	std::stringstream strm;
+
+	strm << "[";
+	for (int i = 0; i < n; ++i){
+		strm << "[";
+		for (int j = 0; j < n; ++j){
+			if(j != 0) strm << ",";
+			strm << elements[static_cast<std::size_t>(i)*n + j];
+		}
+		strm << "]";
+	}
+
+	strm << "]";
+	return strm.str();
+}
+
+template <typename Scalar>
+ElementarySquareMatrix<TElement<Scalar>>& ElementarySquareMatrix<TElement<Scalar>>::operator+=(const ElementarySquareMatrix& m){
+	if(n!=m.n)
+		throw std::domain_error("Matrix dimensions don't match");
+
+	addKernel(elements.size(), elements.data(), m.elements.data());
+
+	return *this;
+}
+
+template <typename Scalar>
+ElementarySquareMatrix<TElement<Scalar>>& ElementarySquareMatrix<TElement<Scalar>>::operator-=(const ElementarySquareMatrix& m){
+	if(n!=m.n)
+		throw std::domain_error("Matrix dimensions don't match");
+
+	subtractKernel(elements.size(), elements.data(), m.elements.data());
+
+	return *this;
+}
+
+template <typename Scalar>
+ElementarySquareMatrix<TElement<Scalar>>& ElementarySquareMatrix<TElement<Scalar>>::operator*=(const ElementarySquareMatrix& m){
+	if(n!=m.n)
+		throw std::domain_error("Wrong dimensions for multiplication");
+
+	std::vector<Scalar, AlignedAllocator<Scalar>> product(elements.size(), 0);
+	multiplyAccumulate(n, elements.data(), m.elements.data(), product.data());
+	elements.swap(product);
+	return *this;
+}
+
+template <typename Scalar>
+ElementarySquareMatrix<TElement<Scalar>> ElementarySquareMatrix<TElement<Scalar>>::operator*(const ElementarySquareMatrix& m) const&{
+	if(n!=m.n)
+		throw std::domain_error("Wrong dimensions for multiplication");
+
+	ElementarySquareMatrix mtemp(n);
+	multiplyAccumulate(n, elements.data(), m.elements.data(), mtemp.elements.data());
+	return mtemp;
+}
+
+template <typename Scalar>
+ElementarySquareMatrix<TElement<Scalar>> ElementarySquareMatrix<TElement<Scalar>>::operator*(const ElementarySquareMatrix& m) &&{
+	*this *= m;
+	return std::move(*this);
+}
+
+template <typename Scalar>
+Concrete64SquareMatrix ElementarySquareMatrix<TElement<Scalar>>::multiplyWide(const ElementarySquareMatrix& m) const{
+	if(n!=m.n)
+		throw std::domain_error("Wrong dimensions for multiplication");
+
+	Concrete64SquareMatrix mtemp(n);
+	multiplyAccumulate(n, elements.data(), m.elements.data(), mtemp.data());
+	return mtemp;
+}
+
+template <typename Scalar>
+ElementarySquareMatrix<TElement<Scalar>> ElementarySquareMatrix<TElement<Scalar>>::pow(int k) const{
+	if(k < 0)
+		throw std::invalid_argument("Negative exponent");
+
+	if(k == 0){
+		ElementarySquareMatrix identity(n);
+		for (int i = 0; i < n; ++i){
+			identity.elements[static_cast<std::size_t>(i)*n + i] = 1;
+		}
+		return identity;
+	}
+
+	// the result starts as the lowest set power of two, which saves multiplying by the identity
+	ElementarySquareMatrix square(*this);
+	while(k % 2 == 0){
+		square *= square;
+		k /= 2;
+	}
+	ElementarySquareMatrix result(square);
+	for (k /= 2; k > 0; k /= 2){
+		square *= square;
+		if(k % 2 == 1)
+			result *= square;
+	}
+	return result;
+}
+
+template class ElementarySquareMatrix<TElement<int>>;
+template class ElementarySquareMatrix<TElement<std::int64_t>>;
@@ -0,0 +1,585 @@
+/**
+	\file concretematrix.h
+	\brief Header for ConcreteSquareMatrix and Concrete64SquareMatrix, the integer specializations of ElementarySquareMatrix
+*/
+
+#ifndef CONCRETEMATRIX_H_INCLUDED
+#define CONCRETEMATRIX_H_INCLUDED
+#include <cstdint>
+#include <string>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "element.h"
+#include "valuation.h"
+#include "alignedallocator.h"
+#include "matrixkernels.h"
+
+template <typename Type>
+class ElementarySquareMatrix;
+
+template <typename Left, typename Right, bool Subtract>
+class ConcreteExpression;
+
+/**
+	\class ElementarySquareMatrix<TElement<Scalar>>
+	\brief Concrete matrix of int or int64_t, values are stored by value in one row-major, cache line aligned buffer
+
+	Arithmetic wraps around on overflow. Use the narrowest scalar that holds the results, or
+	multiplyWide to keep 32-bit storage and accumulate the product in 64 bits.
+*/
+template <typename Scalar>
+class ElementarySquareMatrix<TElement<Scalar>>{
+
+	static_assert(std::is_same<Scalar, int>::value || std::is_same<Scalar, std::int64_t>::value,
+					"Concrete matrices hold int or int64_t");
+
+public:
+	/**
+		\brief Type of the stored values
+	*/
+	using ScalarType = Scalar;
+	/**
+		\brief Unsigned type with the same width, used for wrapping arithmetic
+	*/
+	using WrappedType = typename std::make_unsigned<Scalar>::type;
+
+private:
+	/**
+		\brief Integer to store matrix dimension (n x n)
+	*/
+	int n;
+	/**
+		\brief Matrix is stored row by row in a flat buffer, element (i,j) is at i*n+j
+	*/
+	std::vector<Scalar, AlignedAllocator<Scalar>> elements;
+
+public:
+
+	/**
+		\brief Empty constructor
+	*/
+	ElementarySquareMatrix():n{0}{}
+
+	/**
+		\brief Parametric constructor, creates a zero matrix
+		\param Matrix dimension
+	*/
+	explicit ElementarySquareMatrix(int dim):n{dim},elements(static_cast<std::size_t>(dim)*dim, 0){}
+
+	/**
+		\brief Parametric constructor
+		\param Matrix in string form, eg. "[[i11,i12][i21,i22]]"
+		\throw std::invalid_argument if matrix is in wrong format, or not a square matrix
+	*/
+	explicit ElementarySquareMatrix(const std::string& str_m);
+
+	/**
+		\brief Copy constructor
+		\param Matrix to be copied from
+	*/
+	ElementarySquareMatrix(const ElementarySquareMatrix& m) = default;
+
+	/**
+		\brief Converting constructor from a concrete matrix of another scalar type, narrowing wraps around
+		\param Matrix to copy values from
+	*/
+	template <typename Other>
+	explicit ElementarySquareMatrix(const ElementarySquareMatrix<TElement<Other>>& m)
+		:n{m.getSize()},elements(m.data(), m.data() + static_cast<std::size_t>(m.getSize())*m.getSize()){}
+
+	/**
+		\brief Materializes an element-wise expression in a single pass
+		\param Expression such as A + B - C
+	*/
+	template <typename Left, typename Right, bool Subtract>
+	ElementarySquareMatrix(const ConcreteExpression<Left, Right, Subtract>& e)
+		:n{e.getSize()},elements(static_cast<std::size_t>(n)*n){
+		assign(e);
+	}
+
+	/**
+		\brief Move Constructor
+		\param Matrix to move
+	*/
+	ElementarySquareMatrix(ElementarySquareMatrix&& m) = default;
+
+	/**
+		\brief Default destructor
+	*/
+	virtual ~ElementarySquareMatrix() = default;
+
+	/**
+		\brief Assignment operator for ConcreteSquareMatrix
+		\param ConcreteSquareMatrix to assign from
+		\return Resulting ConcreteSquareMatrix
+	*/
+	ElementarySquareMatrix& operator=(const ElementarySquareMatrix& m) = default;
+
+	/**
+		\brief Move-assignment operator for ConcreteSquareMatrix
+		\param ConcreteSquareMatrix to move-assign from
+		\return Resulting ConcreteSquareMatrix
+	*/
+	ElementarySquareMatrix& operator=(ElementarySquareMatrix&& m) = default;
+
+	/**
+		\brief Assigns an element-wise expression in a single pass, the expression may refer to this matrix
+		\param Expression such as A + B - C
+		\return Resulting ConcreteSquareMatrix
+	*/
+	template <typename Left, typename Right, bool Subtract>
+	ElementarySquareMatrix& operator=(const ConcreteExpression<Left, Right, Subtract>& e){
+		if(n != e.getSize()){
+			n = e.getSize();
+			elements.assign(static_cast<std::size_t>(n)*n, 0);
+		}
+		assign(e);
+		return *this;
+	}
+
+	/**
+		\brief Method to get matrix dimension
+		\return Dimension n of the n x n matrix
+	*/
+	int getSize() const{
+		return n;
+	}
+
+	/**
+		\brief Method to get a single value
+		\param Row index
+		\param Column index
+		\return Value at (i,j)
+	*/
+	Scalar getVal(int i, int j) const{
+		return elements[static_cast<std::size_t>(i)*n + j];
+	}
+
+	/**
+		\brief Method to set a single value
+		\param Row index
+		\param Column index
+		\param Value to store at (i,j)
+	*/
+	void setVal(int i, int j, Scalar v){
+		elements[static_cast<std::size_t>(i)*n + j] = v;
+	}
+
+	/**
+		\brief Raw access to the row-major buffer
+		\return Pointer to element (0,0)
+	*/
+	Scalar* data(){
+		return elements.data();
+	}
+
+	/**
+		\brief Raw access to the row-major buffer
+		\return Pointer to element (0,0)
+	*/
+	const Scalar* data() const{
+		return elements.data();
+	}
+
+	/**
+		\brief Value at a flat row-major index as unsigned, so expression arithmetic wraps
+		\param Index i*n+j
+		\return Value at the index
+	*/
+	WrappedType valueAt(std::size_t index) const{
+		return static_cast<WrappedType>(elements[index]);
+	}
+
+	/**
+		\brief Method for transposing a matrix, cache-oblivious blocked copy
+		\return Transposed matrix
+	*/
+	ElementarySquareMatrix transpose() const&;
+	/**
+		\brief Transposes an expiring matrix in place, without allocating
+		\return Transposed matrix
+	*/
+	ElementarySquareMatrix transpose() &&;
+	/**
+		\brief Transposes the matrix in place, without allocating
+		\return Reference to this matrix
+	*/
+	ElementarySquareMatrix& transposeInPlace();
+
+	/**
+		\brief Operator for checking if two ConcreteSquareMatrices are equal
+		\param ConcreteSquareMatrix to compare to
+		\return Boolean, true if equal, false if not
+	*/
+	bool operator==(const ElementarySquareMatrix& m) const{
+		return n == m.n && elements == m.elements;
+	}
+
+	/**
+		\brief Prints matrix as string using toString to ostream
+		\param Ostream to output in
+	*/
+	void print(std::ostream& os) const{
+		os << toString();
+	}
+
+	/**
+		\brief Turns matrix into string in format [[i11,i12][i21,i22]]
+		\return String representation
+	*/
+	std::string toString() const;
+
+	/**
+		\brief Evaluating a ConcreteSquareMatrix gives the matrix itself
+		\param Valuation, unused
+		\return Copy of the matrix
+	*/
+	ElementarySquareMatrix evaluate(const DenseValuation&) const{
+		return *this;
+	}
+
+	/**
+		\brief Operator for ConcreteSquareMatrix addition
+		\param ConcreteSquareMatrix to add with
+		\return Result of addition
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	ElementarySquareMatrix& operator+=(const ElementarySquareMatrix& m);
+	/**
+		\brief Operator for ConcreteSquareMatrix subtraction
+		\param ConcreteSquareMatrix to subtract with
+		\return Result of subtraction
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	ElementarySquareMatrix& operator-=(const ElementarySquareMatrix& m);
+	/**
+		\brief Operator for ConcreteSquareMatrix multiplication, the product is computed into a new buffer
+		that replaces the old one
+		\param ConcreteSquareMatrix to multiply with
+		\return Result of multiplication
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	ElementarySquareMatrix& operator*=(const ElementarySquareMatrix& m);
+	/**
+		\brief Adds an element-wise expression in a single pass
+		\param Expression to add
+		\return Result of addition
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	template <typename Left, typename Right, bool Subtract>
+	ElementarySquareMatrix& operator+=(const ConcreteExpression<Left, Right, Subtract>& e){
+		return *this = ConcreteExpression<ElementarySquareMatrix, ConcreteExpression<Left, Right, Subtract>, false>(*this, e);
+	}
+	/**
+		\brief Subtracts an element-wise expression in a single pass
+		\param Expression to subtract
+		\return Result of subtraction
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	template <typename Left, typename Right, bool Subtract>
+	ElementarySquareMatrix& operator-=(const ConcreteExpression<Left, Right, Subtract>& e){
+		return *this = ConcreteExpression<ElementarySquareMatrix, ConcreteExpression<Left, Right, Subtract>, true>(*this, e);
+	}
+	/**
+		\brief Operator for ConcreteSquareMatrix multiplication
+		\param ConcreteSquareMatrix to multiply with
+		\return Result of multiplication
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	ElementarySquareMatrix operator*(const ElementarySquareMatrix& m) const&;
+	/**
+		\brief Operator for multiplication with an expiring left operand, the result reuses it through *=
+		\param ConcreteSquareMatrix to multiply with
+		\return Result of multiplication
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	ElementarySquareMatrix operator*(const ElementarySquareMatrix& m) &&;
+	/**
+		\brief Multiplication with 64-bit accumulation, products that overflow Scalar are kept exactly
+		as long as they fit in int64_t, while both operands keep their narrower storage
+		\param Matrix to multiply with
+		\return Result of multiplication as a Concrete64SquareMatrix
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	ElementarySquareMatrix<TElement<std::int64_t>> multiplyWide(const ElementarySquareMatrix& m) const;
+	/**
+		\brief Raises the matrix to a power by repeated squaring, log2(k) squarings and at most as many
+		further multiplications
+		\param Exponent k, 0 gives the identity matrix
+		\return Matrix to the power k
+		\throw std::invalid_argument if k is negative
+	*/
+	ElementarySquareMatrix pow(int k) const;
+
+private:
+	/**
+		\brief Writes every element of an expression of the same size into the buffer
+	*/
+	template <typename Expression>
+	void assign(const Expression& e){
+		WrappedType* out = reinterpret_cast<WrappedType*>(elements.data());
+		parallelChunks(elements.size(), [&e, out](std::size_t begin, std::size_t end){
+			for (std::size_t i = begin; i < end; ++i){
+				out[i] = e.valueAt(i);
+			}
+		});
+	}
+
+	/**
+		\brief Writes a single sum or difference of two matrices through the dispatched SIMD kernels
+	*/
+	template <bool Subtract>
+	void assign(const ConcreteExpression<ElementarySquareMatrix, ElementarySquareMatrix, Subtract>& e){
+		if(Subtract)
+			subtractKernel(elements.size(), elements.data(), e.getLeft().data(), e.getRight().data());
+		else
+			addKernel(elements.size(), elements.data(), e.getLeft().data(), e.getRight().data());
+	}
+
+};
+
+template <typename Scalar>
+using ConcreteMatrix = ElementarySquareMatrix<TElement<Scalar>>;
+using ConcreteSquareMatrix = ConcreteMatrix<int>;
+using Concrete64SquareMatrix = ConcreteMatrix<std::int64_t>;
+
+/**
+	\brief True for concrete matrices of any scalar type
+*/
+template <typename T>
+struct IsConcreteMatrix : std::false_type{};
+
+template <typename Scalar>
+struct IsConcreteMatrix<ConcreteMatrix<Scalar>> : std::true_type{};
+
+/**
+	\brief True for concrete matrices and for expressions built from them
+*/
+template <typename T>
+struct IsConcreteOperand : IsConcreteMatrix<T>{};
+
+template <typename Left, typename Right, bool Subtract>
+struct IsConcreteOperand<ConcreteExpression<Left, Right, Subtract>> : std::true_type{};
+
+/**
+	\brief Matrices are held by reference in an expression, nested expressions by value
+*/
+template <typename T>
+using ExpressionOperand = typename std::conditional<IsConcreteMatrix<T>::value, const T&, const T>::type;
+
+/**
+	\class ConcreteExpression
+	\brief Lazy element-wise sum or difference of concrete matrices with the same scalar type
+
+	Nothing is computed until the expression is assigned to a concrete matrix, which then fills
+	its buffer in one pass with no intermediate matrices. Operands are referenced, not copied, so an
+	expression must be materialized before the matrices it refers to go out of scope.
+*/
+template <typename Left, typename Right, bool Subtract>
+class ConcreteExpression{
+
+	static_assert(std::is_same<typename Left::ScalarType, typename Right::ScalarType>::value,
+					"Operands must have the same scalar type");
+
+public:
+	/**
+		\brief Scalar type of the result
+	*/
+	using ScalarType = typename Left::ScalarType;
+	/**
+		\brief Unsigned type with the same width, used for wrapping arithmetic
+	*/
+	using WrappedType = typename Left::WrappedType;
+
+private:
+	/**
+		\brief Left operand
+	*/
+	ExpressionOperand<Left> left;
+	/**
+		\brief Right operand
+	*/
+	ExpressionOperand<Right> right;
+
+public:
+	/**
+		\brief Parametric constructor
+		\param Left operand
+		\param Right operand
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	ConcreteExpression(const Left& l, const Right& r):left(l),right(r){
+		if(l.getSize() != r.getSize())
+			throw std::domain_error("Matrix dimensions don't match");
+	}
+
+	/**
+		\brief Method to get matrix dimension
+		\return Dimension n of the n x n result
+	*/
+	int getSize() const{
+		return left.getSize();
+	}
+
+	/**
+		\brief Method to get the left operand
+		\return Left operand
+	*/
+	const Left& getLeft() const{
+		return left;
+	}
+
+	/**
+		\brief Method to get the right operand
+		\return Right operand
+	*/
+	const Right& getRight() const{
+		return right;
+	}
+
+	/**
+		\brief Computes one element of the result
+		\param Flat row-major index
+		\return Wrapped result at the index
+	*/
+	WrappedType valueAt(std::size_t index) const{
+		return Subtract ? left.valueAt(index) - right.valueAt(index) : left.valueAt(index) + right.valueAt(index);
+	}
+
+	/**
+		\brief Materializes the expression
+		\return Resulting concrete matrix
+	*/
+	ConcreteMatrix<ScalarType> eval() const{
+		return ConcreteMatrix<ScalarType>(*this);
+	}
+};
+
+/**
+	\brief Operator for ConcreteSquareMatrix addition, returns a lazy expression
+	\param ConcreteSquareMatrix or expression
+	\param ConcreteSquareMatrix or expression to add with
+	\return Expression evaluated on assignment
+	\throw std::domain_error if matrix dimensions dont match
+*/
+template <typename Left, typename Right,
+		typename = typename std::enable_if<IsConcreteOperand<Left>::value && IsConcreteOperand<Right>::value>::type>
+ConcreteExpression<Left, Right, false> operator+(const Left& l, const Right& r){
+	return ConcreteExpression<Left, Right, false>(l, r);
+}
+
+/**
+	\brief Operator for ConcreteSquareMatrix subtraction, returns a lazy expression
+	\param ConcreteSquareMatrix or expression
+	\param ConcreteSquareMatrix or expression to subtract
+	\return Expression evaluated on assignment
+	\throw std::domain_error if matrix dimensions dont match
+*/
+template <typename Left, typename Right,
+		typename = typename std::enable_if<IsConcreteOperand<Left>::value && IsConcreteOperand<Right>::value>::type>
+ConcreteExpression<Left, Right, true> operator-(const Left& l, const Right& r){
+	return ConcreteExpression<Left, Right, true>(l, r);
+}
+
+/**
+	\brief Addition with an expiring left matrix, the sum is written into its buffer
+	\param Expiring concrete matrix
+	\param Concrete matrix or expression to add with
+	\return Result of addition
+	\throw std::domain_error if matrix dimensions dont match
+*/
+template <typename Scalar, typename Right, typename = typename std::enable_if<IsConcreteOperand<Right>::value>::type>
+ConcreteMatrix<Scalar> operator+(ConcreteMatrix<Scalar>&& l, const Right& r){
+	l += r;
+	return std::move(l);
+}
+
+/**
+	\brief Addition with an expiring right matrix, the sum is written into its buffer
+	\param Concrete matrix or expression
+	\param Expiring concrete matrix to add with
+	\return Result of addition
+	\throw std::domain_error if matrix dimensions dont match
+*/
+template <typename Left, typename Scalar, typename = typename std::enable_if<IsConcreteOperand<Left>::value>::type>
+ConcreteMatrix<Scalar> operator+(const Left& l, ConcreteMatrix<Scalar>&& r){
+	r = ConcreteExpression<Left, ConcreteMatrix<Scalar>, false>(l, r);
+	return std::move(r);
+}
+
+/**
+	\brief Addition of two expiring matrices, the sum is written into the left one's buffer
+	\param Expiring concrete matrix
+	\param Expiring concrete matrix to add with
+	\return Result of addition
+	\throw std::domain_error if matrix dimensions dont match
+*/
+template <typename Scalar>
+ConcreteMatrix<Scalar> operator+(ConcreteMatrix<Scalar>&& l, ConcreteMatrix<Scalar>&& r){
+	l += r;
+	return std::move(l);
+}
+
+/**
+	\brief Subtraction with an expiring left matrix, the difference is written into its buffer
+	\param Expiring concrete matrix
+	\param Concrete matrix or expression to subtract
+	\return Result of subtraction
+	\throw std::domain_error if matrix dimensions dont match
+*/
+template <typename Scalar, typename Right, typename = typename std::enable_if<IsConcreteOperand<Right>::value>::type>
+ConcreteMatrix<Scalar> operator-(ConcreteMatrix<Scalar>&& l, const Right& r){
+	l -= r;
+	return std::move(l);
+}
+
+/**
+	\brief Subtraction with an expiring right matrix, the difference is written into its buffer
+	\param Concrete matrix or expression
+	\param Expiring concrete matrix to subtract
+	\return Result of subtraction
+	\throw std::domain_error if matrix dimensions dont match
+*/
+template <typename Left, typename Scalar, typename = typename std::enable_if<IsConcreteOperand<Left>::value>::type>
+ConcreteMatrix<Scalar> operator-(const Left& l, ConcreteMatrix<Scalar>&& r){
+	r = ConcreteExpression<Left, ConcreteMatrix<Scalar>, true>(l, r);
+	return std::move(r);
+}
+
+/**
+	\brief Subtraction of two expiring matrices, the difference is written into the left one's buffer
+	\param Expiring concrete matrix
+	\param Expiring concrete matrix to subtract
+	\return Result of subtraction
+	\throw std::domain_error if matrix dimensions dont match
+*/
+template <typename Scalar>
+ConcreteMatrix<Scalar> operator-(ConcreteMatrix<Scalar>&& l, ConcreteMatrix<Scalar>&& r){
+	l -= r;
+	return std::move(l);
+}
+
+/**
+	\brief Compares an expression with a matrix or another expression without materializing it
+	\param ConcreteSquareMatrix or expression
+	\param ConcreteSquareMatrix or expression to compare to
+	\return Boolean, true if equal, false if not
+*/
+template <typename Left, typename Right,
+		typename = typename std::enable_if<IsConcreteOperand<Left>::value && IsConcreteOperand<Right>::value &&
+			!(IsConcreteMatrix<Left>::value && IsConcreteMatrix<Right>::value)>::type>
+bool operator==(const Left& l, const Right& r){
+	if(l.getSize() != r.getSize())
+		return false;
+	const std::size_t count = static_cast<std::size_t>(l.getSize())*l.getSize();
+	for (std::size_t i = 0; i < count; ++i){
+		if(l.valueAt(i) != r.valueAt(i))
+			return false;
+	}
+	return true;
+}
+
+#endif // CONCRETEMATRIX_H_INCLUDED
@@ -4,6 +4,8 @@
 */
 
 #include <ostream>
+#include <stdexcept>
+#include <type_traits>
 #include "element.h"
 
 std::ostream& operator<<(std::ostream& os, const Element& elem){
@@ -15,48 +17,71 @@ bool operator==(const Element& elem1, const Element& elem2){
 	return elem1.toString() == elem2.toString();
 }
 
-template<>
-int TElement<int>::evaluate(const Valuation& v) const{
-	return val;
+/*
+	Integer elements compute in the matching unsigned type, so overflow wraps
+	around instead of being undefined behaviour.
+*/
+
+template <typename Type>
+using Wrapped = typename std::make_unsigned<Type>::type;
+
+template <typename Type>
+int TElement<Type>::evaluate(const DenseValuation&) const{
+	if(static_cast<int>(val) != val)
+		throw std::out_of_range("Value does not fit in int");
+	return static_cast<int>(val);
 }
 
 template<>
-int TElement<char>::evaluate(const Valuation& v) const{
+int TElement<char>::evaluate(const DenseValuation& v) const{
 	return v.at(val);
 }
 
-template<>
-IntElement& IntElement::operator+=(const IntElement& i){
-	val = val+i.val;
+template <typename Type>
+TElement<Type>& TElement<Type>::operator+=(const TElement<Type>& i){
+	val = static_cast<Type>(static_cast<Wrapped<Type>>(val) + static_cast<Wrapped<Type>>(i.val));
 	return *this;
 }
 
-template<>
-IntElement& IntElement::operator-=(const IntElement& i){
-	val = val-i.val;
+template <typename Type>
+TElement<Type>& TElement<Type>::operator-=(const TElement<Type>& i){
+	val = static_cast<Type>(static_cast<Wrapped<Type>>(val) - static_cast<Wrapped<Type>>(i.val));
 	return *this;
 }
 
-template<>
-IntElement& IntElement::operator*=(const IntElement& i){
-	val = val*i.val;
+template <typename Type>
+TElement<Type>& TElement<Type>::operator*=(const TElement<Type>& i){
+	val = static_cast<Type>(static_cast<Wrapped<Type>>(val) * static_cast<Wrapped<Type>>(i.val));
 	return *this;
 }
 
-IntElement operator+(const IntElement& firstobj, const IntElement& secondobj){
-	IntElement result(firstobj);
+template <typename Type>
+TElement<Type> operator+(const TElement<Type>& firstobj, const TElement<Type>& secondobj){
+	TElement<Type> result(firstobj);
 	result+=secondobj;
 	return result;
 }
 
-IntElement operator-(const IntElement& firstobj, const IntElement& secondobj){
-	IntElement result(firstobj);
+template <typename Type>
+TElement<Type> operator-(const TElement<Type>& firstobj, const TElement<Type>& secondobj){
+	TElement<Type> result(firstobj);
 	result-=secondobj;
 	return result;
 }
 
-IntElement operator*(const IntElement& firstobj, const IntElement& secondobj){
-	IntElement result(firstobj);
+template <typename Type>
+TElement<Type> operator*(const TElement<Type>& firstobj, const TElement<Type>& secondobj){
+	TElement<Type> result(firstobj);
 	result*=secondobj;
 	return result;
-}
\ No newline at end of file
+}
+
+template class TElement<int>;
+template class TElement<std::int64_t>;
+
+template IntElement operator+(const IntElement&, const IntElement&);
+template IntElement operator-(const IntElement&, const IntElement&);
+template IntElement operator*(const IntElement&, const IntElement&);
+template Int64Element operator+(const Int64Element&, const Int64Element&);
+template Int64Element operator-(const Int64Element&, const Int64Element&);
+template Int64Element operator*(const Int64Element&, const Int64Element&);
\ No newline at end of file
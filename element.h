@@ -8,6 +8,7 @@
 #include <string>
 #include <sstream>
 #include <ostream>
+#include <cstdint>
 #include "valuation.h"
 
 /**
@@ -36,7 +37,7 @@ public:
 		\param Used valuation map
 		\return Encapsulated Element
 	*/
-	virtual int evaluate(const Valuation& val) const = 0;
+	virtual int evaluate(const DenseValuation& val) const = 0;
 
 };
 
@@ -59,7 +60,9 @@ bool operator==(const Element& elem1, const Element& elem2);
 
 /**
 	\class TElement
-	\brief Generic class for IntElement and VariableElement
+	\brief Generic class for IntElement, Int64Element and VariableElement
+
+	Arithmetic on the integer types wraps around on overflow instead of being undefined.
 */
 template <typename Type>
 class TElement : public Element{
@@ -86,14 +89,14 @@ public:
 	virtual ~TElement() = default;
 	/**
 		\brief Method to get value
-		\return Value of type char or int
+		\return Value of type char, int or int64_t
 	*/
 	Type getVal() const{
 		return val;
 	}
 	/**
 		\brief Method to get value
-		\tparam Value of type char or int
+		\tparam Value of type char, int or int64_t
 	*/
 	void setVal(Type v){
 		val = v;
@@ -118,24 +121,25 @@ public:
 		\brief Method for evaluating Element according to valuation map
 		\param Used valuation map
 		\return Encapsulated Element
+		\throw std::out_of_range if the value of an Int64Element does not fit in int
 	*/
-	virtual int evaluate(const Valuation& val)const override;
+	virtual int evaluate(const DenseValuation& val)const override;
 	/**
 		\brief Method for TElement<Type> addition
-		\tparam Int value to use in operation
-		\return Returns TElement<Type>, in this case IntElement
+		\tparam Integer value to use in operation
+		\return Returns TElement<Type>, IntElement or Int64Element
 	*/	
 	TElement<Type>& operator+=(const TElement<Type>& i);
 	/**
 		\brief Method for TElement<Type> subtraction
-		\tparam Int value to use in operation
-		\return Returns TElement<Type>, in this case IntElement
+		\tparam Integer value to use in operation
+		\return Returns TElement<Type>, IntElement or Int64Element
 	*/	
 	TElement<Type>& operator-=(const TElement<Type>& i);
 	/**
 		\brief Method for TElement<Type> multiplication
-		\tparam Int value to use in operation
-		\return Returns TElement<Type>, in this case IntElement
+		\tparam Integer value to use in operation
+		\return Returns TElement<Type>, IntElement or Int64Element
 	*/	
 	TElement<Type>& operator*=(const TElement<Type>& i);
 
@@ -143,29 +147,33 @@ public:
 };
 
 using IntElement = TElement<int>;
+using Int64Element = TElement<std::int64_t>;
 using VariableElement = TElement<char>;
 
 /**
-	\brief Operator for adding two IntElements
-	\param First IntElement to use in addition
-	\param Second IntElement to use in addition
+	\brief Operator for adding two IntElements or Int64Elements
+	\param First element to use in addition
+	\param Second element to use in addition
 	\return Result of addition
 */
-IntElement operator+(const IntElement& firstobj,const IntElement& secondobj);
+template <typename Type>
+TElement<Type> operator+(const TElement<Type>& firstobj,const TElement<Type>& secondobj);
 /**
-	\brief Operator for subtracting with two IntElements 
-	\param First IntElement to use in subtraction
-	\param Second IntElement to use in subtraction
+	\brief Operator for subtracting with two IntElements or Int64Elements
+	\param First element to use in subtraction
+	\param Second element to use in subtraction
 	\return Result of subtraction
 */
-IntElement operator-(const IntElement& firstobj,const IntElement& secondobj);
+template <typename Type>
+TElement<Type> operator-(const TElement<Type>& firstobj,const TElement<Type>& secondobj);
 /**
-	\brief Operator for multiplying two IntElements
-	\param First IntElement to use in multiplication
-	\param Second IntElement to use in multiplication
+	\brief Operator for multiplying two IntElements or Int64Elements
+	\param First element to use in multiplication
+	\param Second element to use in multiplication
 	\return Result of multiplying
 */
-IntElement operator*(const IntElement& firstobj,const IntElement& secondobj);
+template <typename Type>
+TElement<Type> operator*(const TElement<Type>& firstobj,const TElement<Type>& secondobj);
 
 
 
@@ -4,224 +4,310 @@
 */
 
 #include "elementarymatrix.h"
+#include "elementpool.h"
+#include "matrixparser.h"
+#include "compiledmatrix.h"
+#include "evaluationcache.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
-template <>
-ElementarySquareMatrix<IntElement>::ElementarySquareMatrix(const std::string& str_m){
-	std::stringstream matrixstring(str_m);
-	char c;
-	int row = 0, column = 0, count = 0;
-	int value;
-
-	matrixstring >> c;
-	if(!matrixstring.good() || c!= '[')
-		throw std::invalid_argument("Not valid square matrix");
-
-	matrixstring >> c;
-	while(!matrixstring.good() || c!=']'){
-		if(!matrixstring.good() || c!= '[')
-			throw std::invalid_argument("Not valid square matrix");
-		std::vector<std::unique_ptr<IntElement>> tempRow;
-		do{
-			matrixstring >> value;
-			if(!matrixstring.good())
-				throw std::invalid_argument("Not valid square matrix");
-			count++;
-			tempRow.push_back(std::unique_ptr<IntElement>(new IntElement(value)));
-			matrixstring >> c;
-			if(!matrixstring.good() || (c!=',' && c!=']'))
-				throw std::invalid_argument("Not valid square matrix");
-		}while(c!=']');
-		if(column == 0)
-			column = count;
-		if(column!= count)
-			throw std::invalid_argument("Not valid square matrix");
-		count=0;
-		elements.push_back(std::move(tempRow));
-		row++;
-		matrixstring >> c;
-	}
+template<>
+ElementarySquareMatrix<Element>::ElementarySquareMatrix(const std::string& str_m){
+	std::vector<std::shared_ptr<const Element>> tempRow;
+	n = tokenizeMatrix(str_m, [this, &tempRow](const MatrixToken& token){
+		if(token.isVariable){
+			tempRow.push_back(ElementPool::global().variable(token.name));
+			variables.set(static_cast<unsigned char>(token.name));
+		}else{
+			tempRow.push_back(ElementPool::global().integer(tokenValue<int>(token)));
+		}
+		if(token.endsRow)
+			elements.push_back(std::move(tempRow));
+	});
+}
 
-	if(column!=row)
-		throw std::invalid_argument("Not valid square matrix");
-	matrixstring >> c;
-	if(!matrixstring.eof())
-		throw std::invalid_argument("Not valid square matrix");
-	n = row;
+/**
+	\brief Simplifies l op r unless turned off, and looks the result up in the pool,
+	dropped is set if simplification discarded an operand that may hold variables
+*/
+static std::shared_ptr<const Element> composite(std::shared_ptr<const Element> l, std::shared_ptr<const Element> r, OpCode opc, bool* dropped){
+	ElementPool& pool = ElementPool::global();
+	if(pool.isSimplifying())
+		return pool.simplified(std::move(l), std::move(r), opc, dropped);
+	return pool.composite(std::move(l), std::move(r), opc);
 }
 
-template<>
-ElementarySquareMatrix<Element>::ElementarySquareMatrix(const std::string& str_m){
-	std::stringstream matrixstring(str_m);
-	char c, symbol;
-	int row = 0, column = 0, count = 0;
-	int value;
-
-	matrixstring >> c;
-	if(!matrixstring.good() || c!= '[')
-		throw std::invalid_argument("Not valid square matrix");
-
-	matrixstring >> c;
-	while(!matrixstring.good() || c!=']'){
-		if(!matrixstring.good() || c!= '[')
-			throw std::invalid_argument("Not valid square matrix");
-		std::vector<std::unique_ptr<Element>> tempRow;
-		do{
-			symbol = matrixstring.peek();
-			if(isalpha(symbol)){
-				matrixstring >> c;
-				tempRow.push_back(std::unique_ptr<Element>(new VariableElement(c)));
-			}else{
-				matrixstring >> value;
-				if(!matrixstring.good())
-					throw std::invalid_argument("Not valid square matrix");
-				tempRow.push_back(std::unique_ptr<Element>(new IntElement(value)));
-			}
-			count++;
-			matrixstring >> c;
-			if(!matrixstring.good() || (c!=',' && c!=']'))
-				throw std::invalid_argument("Not valid square matrix");
-		}while(c!=']');
-		if(column == 0)
-			column = count;
-		if(column!= count)
-			throw std::invalid_argument("Not valid square matrix");
-		count=0;
-		elements.push_back(std::move(tempRow));
-		row++;
-		matrixstring >> c;
+/**
+	\brief Builds the symbolic dot product row[0]*m[0][j] + ... + row[n-1]*m[n-1][j], sharing the operands
+*/
+static std::shared_ptr<const Element> dotProduct(const std::vector<std::shared_ptr<const Element>>& row,
+												const std::vector<std::vector<std::shared_ptr<const Element>>>& m, int j, bool* dropped){
+	std::shared_ptr<const Element> sum = composite(row[0], m[0][j], OpCode::Multiply, dropped);
+	for (std::size_t l = 1; l < row.size(); ++l){
+		sum = composite(std::move(sum), composite(row[l], m[l][j], OpCode::Multiply, dropped), OpCode::Add, dropped);
 	}
+	return sum;
+}
 
-	if(column!=row)
-		throw std::invalid_argument("Not valid square matrix");
-	matrixstring >> c;
-	if(!matrixstring.eof())
-		throw std::invalid_argument("Not valid square matrix");
-	n = row;
-
+/**
+	\brief Collects the variables of every element, each shared node is visited once
+	\param Rows of elements
+	\return Bit c is set if variable c appears in some element
+*/
+static std::bitset<256> referencedVariables(const std::vector<std::vector<std::shared_ptr<const Element>>>& elements){
+	std::bitset<256> found;
+	std::unordered_set<const Element*> visited;
+	std::vector<const Element*> stack;
+	for (const auto& row : elements){
+		for (const auto& root : row){
+			stack.push_back(root.get());
+			while(!stack.empty()){
+				const Element* node = stack.back();
+				stack.pop_back();
+				if(!visited.insert(node).second)
+					continue;
+				if(const CompositeElement* c = dynamic_cast<const CompositeElement*>(node)){
+					stack.push_back(c->getLeft().get());
+					stack.push_back(c->getRight().get());
+				}else if(const VariableElement* v = dynamic_cast<const VariableElement*>(node)){
+					found.set(static_cast<unsigned char>(v->getVal()));
+				}
+			}
+		}
+	}
+	return found;
 }
 
 template <>
-ConcreteSquareMatrix& ConcreteSquareMatrix::operator+=(const ConcreteSquareMatrix& m){
-	if(n!=m.n)
-		throw std::domain_error("Matrix dimensions don't match");
+SymbolicSquareMatrix SymbolicSquareMatrix::operator+(const SymbolicSquareMatrix& m) const&{
+	if(n!=m.n) throw std::domain_error("Matrix dimensions don't match");
+
+	SymbolicSquareMatrix mtemp;
+	bool dropped = false;
 
 	for (int i = 0; i < n; ++i){
+		std::vector<std::shared_ptr<const Element>> tempRow;
 		for (int j = 0; j < n; ++j){
-			*elements[i][j] += *m.elements[i][j];
+			tempRow.push_back(composite(elements[i][j], m.elements[i][j], OpCode::Add, &dropped));
 		}
+		mtemp.elements.push_back(std::move(tempRow));
 	}
-
-	return *this;
+	mtemp.n = n;
+	mtemp.variables = dropped ? referencedVariables(mtemp.elements) : variables | m.variables;
+	return mtemp;
 }
 
 template <>
-ConcreteSquareMatrix& ConcreteSquareMatrix::operator-=(const ConcreteSquareMatrix& m){
-	if(n!=m.n)
-		throw std::domain_error("Matrix dimensions don't match");
+SymbolicSquareMatrix SymbolicSquareMatrix::operator+(const SymbolicSquareMatrix& m) &&{
+	if(&m == this) return static_cast<const SymbolicSquareMatrix&>(*this) + m;
+	if(n!=m.n) throw std::domain_error("Matrix dimensions don't match");
+	program.reset();
+	cache.reset();
+	bool dropped = false;
 
 	for (int i = 0; i < n; ++i){
 		for (int j = 0; j < n; ++j){
-			*elements[i][j] -= *m.elements[i][j];
+			elements[i][j] = composite(std::move(elements[i][j]), m.elements[i][j], OpCode::Add, &dropped);
 		}
 	}
-
-	return *this;
+	variables = dropped ? referencedVariables(elements) : variables | m.variables;
+	return std::move(*this);
 }
 
 template <>
-ConcreteSquareMatrix& ConcreteSquareMatrix::operator*=(const ConcreteSquareMatrix& m){
-	if(n!=m.n)
-		throw std::domain_error("Wrong dimensions for multiplication");
+SymbolicSquareMatrix SymbolicSquareMatrix::operator-(const SymbolicSquareMatrix& m) const&{
+	if(n!=m.n) throw std::domain_error("Matrix dimensions don't match");
 
-	ConcreteSquareMatrix temp(*this);
+	SymbolicSquareMatrix mtemp;
+	bool dropped = false;
 
 	for (int i = 0; i < n; ++i){
+		std::vector<std::shared_ptr<const Element>> tempRow;
 		for (int j = 0; j < n; ++j){
-			for (int l = 0; l < n; ++l){
-				*temp.elements[i][j] += *elements[i][l] * *m.elements[l][j];
-			}
+			tempRow.push_back(composite(elements[i][j], m.elements[i][j], OpCode::Subtract, &dropped));
 		}
+		mtemp.elements.push_back(std::move(tempRow));
 	}
-	temp -= *this;
-	elements = std::move(temp.elements);
-	return *this;
+	mtemp.n = n;
+	mtemp.variables = dropped ? referencedVariables(mtemp.elements) : variables | m.variables;
+	return mtemp;
 }
 
 template <>
-SymbolicSquareMatrix SymbolicSquareMatrix::operator+(const SymbolicSquareMatrix& m) const{
+SymbolicSquareMatrix SymbolicSquareMatrix::operator-(const SymbolicSquareMatrix& m) &&{
+	if(&m == this) return static_cast<const SymbolicSquareMatrix&>(*this) - m;
 	if(n!=m.n) throw std::domain_error("Matrix dimensions don't match");
-
-	SymbolicSquareMatrix mtemp(*this);
+	program.reset();
+	cache.reset();
+	bool dropped = false;
 
 	for (int i = 0; i < n; ++i){
 		for (int j = 0; j < n; ++j){
-			mtemp.elements[i][j] = std::unique_ptr<Element>(new CompositeElement(*elements[i][j], *m.elements[i][j],
-																			std::plus<int>(), '+'));
+			elements[i][j] = composite(std::move(elements[i][j]), m.elements[i][j], OpCode::Subtract, &dropped);
 		}
 	}
-	return mtemp;
+	variables = dropped ? referencedVariables(elements) : variables | m.variables;
+	return std::move(*this);
 }
 
 template <>
-SymbolicSquareMatrix SymbolicSquareMatrix::operator-(const SymbolicSquareMatrix& m) const{
+SymbolicSquareMatrix SymbolicSquareMatrix::operator*(const SymbolicSquareMatrix& m) const&{
 	if(n!=m.n) throw std::domain_error("Matrix dimensions don't match");
 
-	SymbolicSquareMatrix mtemp(*this);
+	SymbolicSquareMatrix mtemp;
+	bool dropped = false;
 
 	for (int i = 0; i < n; ++i){
+		std::vector<std::shared_ptr<const Element>> tempRow;
 		for (int j = 0; j < n; ++j){
-			mtemp.elements[i][j] = std::unique_ptr<Element>(new CompositeElement(*elements[i][j], *m.elements[i][j],
-																			std::minus<int>(), '-'));
+			tempRow.push_back(dotProduct(elements[i], m.elements, j, &dropped));
 		}
+		mtemp.elements.push_back(std::move(tempRow));
 	}
-	return mtemp;
 
+	mtemp.n = m.n;
+	mtemp.variables = dropped ? referencedVariables(mtemp.elements) : variables | m.variables;
+	return mtemp;
 }
 
 template <>
-SymbolicSquareMatrix SymbolicSquareMatrix::operator*(const SymbolicSquareMatrix& m) const{
+SymbolicSquareMatrix SymbolicSquareMatrix::operator*(const SymbolicSquareMatrix& m) &&{
+	if(&m == this) return static_cast<const SymbolicSquareMatrix&>(*this) * m;
 	if(n!=m.n) throw std::domain_error("Matrix dimensions don't match");
+	program.reset();
+	cache.reset();
 
-	SymbolicSquareMatrix mtemp;
+	std::vector<std::shared_ptr<const Element>> tempRow(n);
+	bool dropped = false;
 
 	for (int i = 0; i < n; ++i){
-		std::vector<std::unique_ptr<Element>> tempRow;
 		for (int j = 0; j < n; ++j){
-			CompositeElement tempElement(*elements[i][0], *m.elements[0][j],
-										std::multiplies<int>(), '*');
-			for (int l = 1; l < n; ++l){
-				CompositeElement tempSecondElement(*elements[i][l], *m.elements[l][j],
-										std::multiplies<int>(), '*');
-
-				tempElement = CompositeElement(tempElement, tempSecondElement, 
-										std::plus<int>(), '+');
+			tempRow[j] = dotProduct(elements[i], m.elements, j, &dropped);
+		}
+		// the old row is only read while building its own result row, so the two are swapped
+		std::swap(elements[i], tempRow);
+	}
+	variables = dropped ? referencedVariables(elements) : variables | m.variables;
+
+	return std::move(*this);
+}
+
+template <>
+SymbolicSquareMatrix SymbolicSquareMatrix::pow(int k) const{
+	if(k < 0) throw std::invalid_argument("Negative exponent");
+
+	if(k == 0){
+		SymbolicSquareMatrix identity;
+		std::shared_ptr<const Element> zero = ElementPool::global().integer(0);
+		std::shared_ptr<const Element> one = ElementPool::global().integer(1);
+		for (int i = 0; i < n; ++i){
+			std::vector<std::shared_ptr<const Element>> tempRow(n, zero);
+			tempRow[i] = one;
+			identity.elements.push_back(std::move(tempRow));
+		}
+		identity.n = n;
+		return identity;
+	}
+
+	// the result starts as the lowest set power of two, so no identity factor appears in the trees
+	SymbolicSquareMatrix square(*this);
+	while(k % 2 == 0){
+		square = square * square;
+		k /= 2;
+	}
+	SymbolicSquareMatrix result(square);
+	for (k /= 2; k > 0; k /= 2){
+		square = square * square;
+		if(k % 2 == 1)
+			result = std::move(result) * square;
+	}
+	return result;
+}
+
+template <>
+SymbolicSquareMatrix SymbolicSquareMatrix::partialEvaluate(const DenseValuation& val) const{
+	SymbolicSquareMatrix mtemp;
+	mtemp.n = n;
+
+	// Post-order walk with an explicit stack, every shared node is rebuilt once
+	std::unordered_map<const Element*, std::shared_ptr<const Element>> done;
+	std::vector<std::pair<const std::shared_ptr<const Element>*, bool>> stack;
+	for (const auto& row : elements){
+		std::vector<std::shared_ptr<const Element>> tempRow;
+		tempRow.reserve(n);
+		for (const auto& root : row){
+			stack.emplace_back(&root, false);
+			while(!stack.empty()){
+				const std::shared_ptr<const Element>& node = *stack.back().first;
+				const bool expanded = stack.back().second;
+				if(done.count(node.get())){
+					stack.pop_back();
+					continue;
+				}
+
+				const CompositeElement* c = dynamic_cast<const CompositeElement*>(node.get());
+				if(!c){
+					const VariableElement* v = dynamic_cast<const VariableElement*>(node.get());
+					if(v && val.contains(v->getVal())){
+						done.emplace(node.get(), ElementPool::global().integer(val[v->getVal()]));
+					}else{
+						done.emplace(node.get(), node);
+					}
+				}else if(!expanded){
+					stack.back().second = true;
+					stack.emplace_back(&c->getRight(), false);
+					stack.emplace_back(&c->getLeft(), false);
+					continue;
+				}else{
+					done.emplace(node.get(), ElementPool::global().simplified(done.at(c->getLeft().get()),
+																			done.at(c->getRight().get()), c->getOp()));
+				}
+				stack.pop_back();
 			}
-			tempRow.push_back(std::unique_ptr<Element>(tempElement.clone()));
+			tempRow.push_back(done.at(root.get()));
 		}
 		mtemp.elements.push_back(std::move(tempRow));
 	}
-
-	mtemp.n = m.n;
+	// substitution may multiply other variables by zero, so the set is taken from the result
+	mtemp.variables = referencedVariables(mtemp.elements);
 	return mtemp;
 }
 
-template<>
-ConcreteSquareMatrix ConcreteSquareMatrix::operator+(const ConcreteSquareMatrix& m) const{
-	ConcreteSquareMatrix mtemp(*this);
-	mtemp+=m;
-	return mtemp;
+template <>
+SymbolicSquareMatrix SymbolicSquareMatrix::simplify() const{
+	return partialEvaluate(DenseValuation());
 }
 
-template<>
-ConcreteSquareMatrix ConcreteSquareMatrix::operator-(const ConcreteSquareMatrix& m) const{
-	ConcreteSquareMatrix mtemp(*this);
-	mtemp-=m;
-	return mtemp;
+template <>
+CompiledMatrix SymbolicSquareMatrix::compile() const{
+	return CompiledMatrix(*this);
 }
 
-template<>
-ConcreteSquareMatrix ConcreteSquareMatrix::operator*(const ConcreteSquareMatrix& m) const{
-	ConcreteSquareMatrix mtemp(*this);
-	mtemp*=m;
-	return mtemp;
-}
\ No newline at end of file
+template <>
+std::shared_ptr<const CompiledMatrix> SymbolicSquareMatrix::getProgram() const{
+	std::shared_ptr<const CompiledMatrix> compiled = std::atomic_load(&program);
+	if(!compiled){
+		// concurrent first calls may both compile, either program is correct
+		compiled = std::make_shared<const CompiledMatrix>(*this);
+		std::atomic_store(&program, compiled);
+	}
+	return compiled;
+}
+
+template <>
+void SymbolicSquareMatrix::enableCache(std::size_t maxBytes){
+	cache = std::make_shared<EvaluationCache>(maxBytes);
+}
+
+template <>
+ConcreteSquareMatrix SymbolicSquareMatrix::evaluate(const DenseValuation& val) const{
+	if(cache)
+		return cache->evaluate(*getProgram(), val);
+	return getProgram()->evaluate(val);
+}
+
+template <>
+std::vector<ConcreteSquareMatrix> SymbolicSquareMatrix::evaluateBatch(const ValuationBatch& vals) const{
+	return getProgram()->evaluateBatch(vals);
+}
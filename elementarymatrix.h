@@ -5,15 +5,21 @@
 
 #ifndef ELEMENTARYMATRIX_H_INCLUDED
 #define ELEMENTARYMATRIX_H_INCLUDED
+#include <bitset>
 #include <string>
 #include <sstream>
 #include <ostream>
 #include <vector>
+#include <memory>
 #include "element.h"
 #include "compositeelement.h"
+#include "concretematrix.h"
 #include "valuation.h"
 #include <vector>
 
+class CompiledMatrix;
+class EvaluationCache;
+
 /**
 	\class ElementarySquareMatrix
 	\brief Generic class for ConcreteSquareMatrix and SymbolicSquareMatrix
@@ -27,11 +33,23 @@ private:
 	*/
 	int n;
 	/**
-		\brief Matrix is stored in a 2D vector containing unique pointers to Element-objects
+		\brief Matrix is stored in a 2D vector containing shared pointers to immutable Element-objects,
+		copies and results of operations share subtrees instead of cloning them
 	*/
-	std::vector<std::vector<std::unique_ptr<Type>>> elements;
-	
-	friend ElementarySquareMatrix<Element>;
+	std::vector<std::vector<std::shared_ptr<const Type>>> elements;
+	/**
+		\brief Set bit for every variable name the elements refer to, kept up to date by the operators
+	*/
+	std::bitset<256> variables;
+	/**
+		\brief Program built by the first evaluation and shared by copies, reset when the elements change,
+		read and written with the atomic shared_ptr functions so const evaluations may run concurrently
+	*/
+	mutable std::shared_ptr<const CompiledMatrix> program;
+	/**
+		\brief Optional cache of evaluation results, shared by copies, dropped when the elements change
+	*/
+	std::shared_ptr<EvaluationCache> cache;
 
 public:
 
@@ -48,19 +66,15 @@ public:
 	explicit ElementarySquareMatrix(const std::string& str_m);
 
 	/**
-		\brief Copy constructor
+		\brief Copy constructor, the elements are shared
 		\param Matrix to be copied from
 	*/
 	ElementarySquareMatrix(const ElementarySquareMatrix& m){
-		for(const auto& row : m.elements){
-			std::vector<std::unique_ptr<Type>> tempRow;
-			for(const auto& column : row){
-				Type* tempPtr = dynamic_cast<Type*>(column->clone());
-				tempRow.push_back(std::unique_ptr<Type>(tempPtr));
-			}
-			elements.push_back(std::move(tempRow));
-		}
+		elements = m.elements;
 		n = m.n;
+		variables = m.variables;
+		program = std::atomic_load(&m.program);
+		cache = m.cache;
 	}
 
 	/**
@@ -70,6 +84,9 @@ public:
 	ElementarySquareMatrix(ElementarySquareMatrix&& m){
 		n = m.n;
 		elements = std::move(m.elements);
+		variables = m.variables;
+		program = std::move(m.program);
+		cache = std::move(m.cache);
 	}
 
 	/**
@@ -83,11 +100,13 @@ public:
 		\return Resulting ElementarySquareMatrix
 	*/	
 	ElementarySquareMatrix<Type>& operator=(const ElementarySquareMatrix<Type>& m){
-		if(elements == m.elements) return *this;
+		if(this == &m) return *this;
 
-		ElementarySquareMatrix<Type> tempcopy{m};
 		n = m.n;
-		std::swap(elements,tempcopy.elements);
+		elements = m.elements;
+		variables = m.variables;
+		program = std::atomic_load(&m.program);
+		cache = m.cache;
 		return *this;
 	}
 
@@ -97,34 +116,76 @@ public:
 		\return Resulting ElementarySquareMatrix
 	*/	
 	ElementarySquareMatrix<Type>& operator=(ElementarySquareMatrix<Type>&& m){
-		if(elements == m.elements) return *this;	
+		if(this == &m) return *this;
 		n = m.n;
 		elements = std::move(m.elements);
+		variables = m.variables;
+		program = std::move(m.program);
+		cache = std::move(m.cache);
 		return *this;
 	}
 
 	/**
-		\brief Method for transposing a matrix
+		\brief Method to get matrix dimension
+		\return Dimension n of the n x n matrix
+	*/
+	int getSize() const{
+		return n;
+	}
+
+	/**
+		\brief Method to get the variables the matrix refers to, exact also when variables cancel
+		\return Bit c is set if variable c appears in some element
+	*/
+	const std::bitset<256>& getVariables() const{
+		return variables;
+	}
+
+	/**
+		\brief Method to get a single element
+		\param Row index
+		\param Column index
+		\return Element at (i,j)
+	*/
+	const Type& getElement(int i, int j) const{
+		return *elements[i][j];
+	}
+
+	/**
+		\brief Method for transposing a matrix, the elements are shared
 		\return Transposed matrix
 	*/	
-	ElementarySquareMatrix transpose() const{
+	ElementarySquareMatrix transpose() const&{
 		ElementarySquareMatrix<Type> mtemp;
-		std::vector<std::vector<std::unique_ptr<Type>>> tempElements(n);
+		mtemp.elements.resize(n);
 	
-		for(auto& row : elements){
-			int index = 0;
-			for(auto& column : row){
-				Type* tempPtr = dynamic_cast<Type*>(column->clone());
-				tempElements[index].push_back(std::unique_ptr<Type>(tempPtr));
-				index++;
+		for (int j = 0; j < n; ++j){
+			mtemp.elements[j].reserve(n);
+			for (int i = 0; i < n; ++i){
+				mtemp.elements[j].push_back(elements[i][j]);
 			}
 		}
 
-		mtemp.elements = std::move(tempElements);
 		mtemp.n = n;
+		mtemp.variables = variables;
 		return mtemp;
 	}
 
+	/**
+		\brief Transposes an expiring matrix in place by swapping its element pointers
+		\return Transposed matrix
+	*/
+	ElementarySquareMatrix transpose() &&{
+		for (int i = 0; i < n; ++i){
+			for (int j = i + 1; j < n; ++j){
+				std::swap(elements[i][j], elements[j][i]);
+			}
+		}
+		program.reset();
+		cache.reset();
+		return std::move(*this);
+	}
+
 	/**
 		\brief Operator for checking if two ElementarySquareMatrices are equal
 		\param ElementarySquareMatrix to compare to
@@ -165,72 +226,138 @@ public:
 		return strm.str();
 	}
 	/**
-		\brief Method for evaluating a SymbolicSquareMatrix
-		\param Valuation map to be used
+		\brief Method for evaluating a SymbolicSquareMatrix, the valuation is checked before any arithmetic.
+		The first call compiles the matrix, so every distinct subexpression is evaluated once per call
+		however many elements share it
+		\param Valuation to be used, a Valuation map converts implicitly
 		\return Resulting ConcreteSquareMatrix
+		\throw std::out_of_range naming every variable that is not mapped
 	*/	
-	ElementarySquareMatrix<IntElement> evaluate(const Valuation& val) const{
-		ElementarySquareMatrix<IntElement> m;
-		int i;
+	ElementarySquareMatrix<IntElement> evaluate(const DenseValuation& val) const;
+	/**
+		\brief Method for evaluating every element as an independent tree, without compiling
+		\param Valuation to be used, a Valuation map converts implicitly
+		\return Resulting ConcreteSquareMatrix
+		\throw std::out_of_range naming every variable that is not mapped
+	*/
+	ElementarySquareMatrix<IntElement> evaluateTrees(const DenseValuation& val) const{
+		const std::bitset<256> missing = getVariables() & ~val.getPresent();
+		if(missing.any())
+			throw std::out_of_range(unmappedMessage(missing));
+
+		ElementarySquareMatrix<IntElement> m(n);
+		int* out = m.data();
 		for(const auto& row : elements){
-			std::vector<std::unique_ptr<IntElement>> tempRow;
 			for(const auto& column : row){
-				try{
-					i = column->evaluate(val);
-				}
-				catch(const std::out_of_range& oor){
-					throw std::out_of_range("Out of range, values not mapped");
-				}
-	
-					tempRow.push_back(std::unique_ptr<IntElement>(new IntElement(i)));
-				}
-				m.elements.push_back(std::move(tempRow));
+				*out++ = column->evaluate(val);
 			}
-			m.n = n;
+		}
 		return m;
 	}
 	/**
-		\brief Operator for ConcreteSquareMatrix addition
-		\param ConcreteSquareMatrix to add with
+		\brief Operator for ElementarySquareMatrix addition
+		\tparam ElementarySquareMatrix to add with
 		\return Result of addition
 		\throw std::domain_error if matrix dimensions dont match
 	*/
-	ElementarySquareMatrix<IntElement>& operator+=(const ElementarySquareMatrix<IntElement>& m);
+	ElementarySquareMatrix<Type> operator+(const ElementarySquareMatrix<Type>& m) const&;
 	/**
-		\brief Operator for ConcreteSquareMatrix subtraction
-		\param ConcreteSquareMatrix to subtract with
-		\return Result of subtraction
-		\throw std::domain_error if matrix dimensions dont match
-	*/	
-	ElementarySquareMatrix<IntElement>& operator-=(const ElementarySquareMatrix<IntElement>& m);
-	/**
-		\brief Operator for ConcreteSquareMatrix multiplication
-		\param ConcreteSquareMatrix to multiply with
-		\return Result of multiplication
+		\brief Operator for addition with an expiring left operand, its rows are reused for the result
+		\tparam ElementarySquareMatrix to add with
+		\return Result of addition
 		\throw std::domain_error if matrix dimensions dont match
-	*/	
-	ElementarySquareMatrix<IntElement>& operator*=(const ElementarySquareMatrix<IntElement>& m);
+	*/
+	ElementarySquareMatrix<Type> operator+(const ElementarySquareMatrix<Type>& m) &&;
 	/**
-		\brief Operator for ElementarySquareMatrix addition
+		\brief Operator for ElementarySquareMatrix subtraction
 		\tparam ElementarySquareMatrix to subtract with
-		\return Result of addition
+		\return Result of subtraction
 		\throw std::domain_error if matrix dimensions dont match
 	*/
-	ElementarySquareMatrix<Type> operator+(const ElementarySquareMatrix<Type>& m) const;
+	ElementarySquareMatrix<Type> operator-(const ElementarySquareMatrix<Type>& m) const&;
 	/**
-		\brief Operator for ElementarySquareMatrix subtraction
+		\brief Operator for subtraction with an expiring left operand, its rows are reused for the result
 		\tparam ElementarySquareMatrix to subtract with
 		\return Result of subtraction
 		\throw std::domain_error if matrix dimensions dont match
 	*/
-	ElementarySquareMatrix<Type> operator-(const ElementarySquareMatrix<Type>& m) const;
+	ElementarySquareMatrix<Type> operator-(const ElementarySquareMatrix<Type>& m) &&;
 	/**
 		\brief Operator for ElementarySquareMatrix multiplication
-		\tparam ElementarySquareMatrix to subtract with
+		\tparam ElementarySquareMatrix to multiply with
 		\return Result of multiplication
 		\throw std::domain_error if matrix dimensions dont match
 	*/
-	ElementarySquareMatrix<Type> operator*(const ElementarySquareMatrix<Type>& m) const;
+	ElementarySquareMatrix<Type> operator*(const ElementarySquareMatrix<Type>& m) const&;
+	/**
+		\brief Operator for multiplication with an expiring left operand, its rows are replaced in place
+		\tparam ElementarySquareMatrix to multiply with
+		\return Result of multiplication
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	ElementarySquareMatrix<Type> operator*(const ElementarySquareMatrix<Type>& m) &&;
+	/**
+		\brief Raises the matrix to a power by repeated squaring, log2(k) squarings and at most as many
+		further multiplications, every element tree of the result shares the trees of the squares
+		\param Exponent k, 0 gives the identity matrix
+		\return Matrix to the power k
+		\throw std::invalid_argument if k is negative
+	*/
+	ElementarySquareMatrix<Type> pow(int k) const;
+	/**
+		\brief Lowers the matrix into a register program, faster than evaluate when the same matrix
+		is evaluated against many valuations
+		\return Compiled matrix
+	*/
+	CompiledMatrix compile() const;
+	/**
+		\brief Attaches a least recently used cache of evaluation results, evaluate then returns the cached
+		result for a valuation agreeing with an earlier one on the variables of the matrix. Copies share
+		the cache, results of operations start without one
+		\param Capacity in bytes
+	*/
+	void enableCache(std::size_t maxBytes);
+	/**
+		\brief Detaches the evaluation cache
+	*/
+	void disableCache(){
+		cache.reset();
+	}
+	/**
+		\brief Method to get the evaluation cache
+		\return Cache, nullptr if none is attached
+	*/
+	const EvaluationCache* getCache() const{
+		return cache.get();
+	}
+	/**
+		\brief Method to get the program evaluate uses, compiled on first use
+		\return Shared compiled matrix
+	*/
+	std::shared_ptr<const CompiledMatrix> getProgram() const;
+	/**
+		\brief Rebuilds every element bottom-up through the simplification rules of ElementPool, the operators
+		already apply them to the nodes they create, so this is for trees built from unsimplified nodes
+		\return Simplified matrix, its variable set holds only the variables left in the elements
+	*/
+	ElementarySquareMatrix<Type> simplify() const;
+	/**
+		\brief Substitutes the variables mapped in the valuation and simplifies, the other variables stay
+		symbolic. Evaluating the result with the remaining variables gives the same matrix as evaluating
+		this with all of them
+		\param Valuation binding any subset of the variables, a Valuation map converts implicitly
+		\return Reduced matrix, its variable set holds only the variables left in the elements
+	*/
+	ElementarySquareMatrix<Type> partialEvaluate(const DenseValuation& val) const;
+	/**
+		\brief Evaluates the matrix for many valuations through one compiled program
+		\param Valuations to be used, every supplied variable must have the same number of values,
+		which is the batch size also for a matrix without variables
+		\return Resulting ConcreteSquareMatrix of every valuation
+		\throw std::out_of_range if a variable of the matrix is not mapped
+		\throw std::invalid_argument if the supplied variables have different numbers of values, or if none are supplied
+	*/
+	std::vector<ElementarySquareMatrix<IntElement>> evaluateBatch(const ValuationBatch& vals) const;
 
 };
 
@@ -246,7 +373,6 @@ std::ostream& operator<<(std::ostream& os, const ElementarySquareMatrix<Type>& m
 	return os;
 }
 
-using ConcreteSquareMatrix = ElementarySquareMatrix<IntElement>;
 using SymbolicSquareMatrix = ElementarySquareMatrix<Element>;
 
 #endif // ELEMENTARYMATRIX_H_INCLUDED
\ No newline at end of file
@@ -0,0 +1,183 @@
+/**
+	\file elementpool.cpp
+	\brief Code for ElementPool class
+*/
+
+#include <algorithm>
+#include <utility>
+#include "elementpool.h"
+
+/**
+	\brief Kinds of pooled nodes
+*/
+enum NodeKind : char{
+	IntegerNode,
+	VariableNode,
+	CompositeNode
+};
+
+std::size_t ElementPool::KeyHash::operator()(const Key& k) const{
+	std::size_t h = std::hash<int>()(k.value);
+	h = h*31 + static_cast<unsigned char>(k.kind);
+	h = h*31 + static_cast<unsigned char>(k.op);
+	h ^= std::hash<const Element*>()(k.left) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+	h ^= std::hash<const Element*>()(k.right) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+	return h;
+}
+
+void ElementPool::sweep(){
+	for (auto entry = table.begin(); entry != table.end();){
+		if(entry->second.expired())
+			entry = table.erase(entry);
+		else
+			++entry;
+	}
+}
+
+std::shared_ptr<const Element> ElementPool::intern(const Key& key, const std::function<std::shared_ptr<const Element>()>& make){
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = table.find(key);
+	if(it != table.end()){
+		if(std::shared_ptr<const Element> existing = it->second.lock()){
+			++hits;
+			return existing;
+		}
+	}
+
+	++misses;
+	std::shared_ptr<const Element> created = make();
+	if(it != table.end()){
+		it->second = created;
+		return created;
+	}
+
+	if(table.size() >= sweepAt){
+		sweep();
+		sweepAt = std::max<std::size_t>(1024, 2*table.size());
+	}
+	table.emplace(key, created);
+	return created;
+}
+
+std::shared_ptr<const Element> ElementPool::integer(int value){
+	const Key key{IntegerNode, 0, value, nullptr, nullptr};
+	return intern(key, [&]{
+		return std::shared_ptr<const Element>(makeArenaNode<IntElement>(arena, value));
+	});
+}
+
+std::shared_ptr<const Element> ElementPool::variable(char name){
+	const Key key{VariableNode, name, 0, nullptr, nullptr};
+	return intern(key, [&]{
+		return std::shared_ptr<const Element>(makeArenaNode<VariableElement>(arena, name));
+	});
+}
+
+std::shared_ptr<const Element> ElementPool::composite(std::shared_ptr<const Element> e1, std::shared_ptr<const Element> e2, OpCode opc){
+	const Key key{CompositeNode, static_cast<char>(opc), 0, e1.get(), e2.get()};
+	return intern(key, [&]{
+		return std::shared_ptr<const Element>(makeArenaNode<CompositeElement>(arena, std::move(e1), std::move(e2), opc));
+	});
+}
+
+/**
+	\brief Checks if a node is an integer
+	\param Node
+	\param Set to the value of an integer node
+	\return Boolean, true for an integer node
+*/
+static bool isConstant(const Element& e, int& value){
+	const IntElement* i = dynamic_cast<const IntElement*>(&e);
+	if(i)
+		value = i->getVal();
+	return i != nullptr;
+}
+
+/**
+	\brief Splits a node into a constant factor and the rest, (c*x) gives c and x, any other x gives 1 and x
+*/
+static const std::shared_ptr<const Element>& splitTerm(const std::shared_ptr<const Element>& e, int& coefficient){
+	const CompositeElement* c = dynamic_cast<const CompositeElement*>(e.get());
+	if(c && c->getOp() == OpCode::Multiply && isConstant(*c->getLeft(), coefficient))
+		return c->getRight();
+	coefficient = 1;
+	return e;
+}
+
+std::shared_ptr<const Element> ElementPool::simplified(std::shared_ptr<const Element> e1, std::shared_ptr<const Element> e2, OpCode opc,
+														bool* dropped){
+	int a = 0, b = 0;
+	const bool constant1 = isConstant(*e1, a);
+	const bool constant2 = isConstant(*e2, b);
+	if(constant1 && constant2)
+		return integer(applyOp(opc, a, b));
+
+	if(opc == OpCode::Multiply){
+		if(constant2){
+			std::swap(e1, e2);
+			a = b;
+		}else if(!constant1){
+			return composite(std::move(e1), std::move(e2), opc);
+		}
+		// e1 is the constant a from here on, e2 is not an integer
+		if(a == 0){
+			if(dropped)
+				*dropped = true;
+			return e1;
+		}
+		if(a == 1)
+			return e2;
+		int inner;
+		const std::shared_ptr<const Element>& rest = splitTerm(e2, inner);
+		if(rest != e2)
+			return simplified(integer(applyOp(OpCode::Multiply, a, inner)), rest, OpCode::Multiply, dropped);
+		return composite(std::move(e1), std::move(e2), opc);
+	}
+
+	if(constant2 && b == 0)
+		return e1;
+	if(opc == OpCode::Add && constant1 && a == 0)
+		return e2;
+
+	int c1, c2;
+	const std::shared_ptr<const Element>& term1 = splitTerm(e1, c1);
+	const std::shared_ptr<const Element>& term2 = splitTerm(e2, c2);
+	if(term1 == term2)
+		return simplified(integer(applyOp(opc, c1, c2)), term1, OpCode::Multiply, dropped);
+
+	if(constant2){
+		const CompositeElement* sum = dynamic_cast<const CompositeElement*>(e1.get());
+		int c;
+		if(sum && sum->getOp() == OpCode::Add && isConstant(*sum->getRight(), c))
+			return simplified(sum->getLeft(), integer(applyOp(opc, c, b)), OpCode::Add, dropped);
+	}
+	return composite(std::move(e1), std::move(e2), opc);
+}
+
+std::size_t ElementPool::getLiveCount(){
+	std::lock_guard<std::mutex> lock(mutex);
+	sweep();
+	return table.size();
+}
+
+std::size_t ElementPool::getBytesUsed(){
+	std::lock_guard<std::mutex> lock(mutex);
+	sweep();
+	return arena.getBytesUsed();
+}
+
+std::size_t ElementPool::getHitCount(){
+	std::lock_guard<std::mutex> lock(mutex);
+	return hits;
+}
+
+std::size_t ElementPool::getMissCount(){
+	std::lock_guard<std::mutex> lock(mutex);
+	return misses;
+}
+
+ElementPool& ElementPool::global(){
+	static ElementPool* pool = new ElementPool;
+	return *pool;
+}
@@ -0,0 +1,196 @@
+/**
+	\file elementpool.h
+	\brief Header for ElementPool class
+*/
+
+#ifndef ELEMENTPOOL_H_INCLUDED
+#define ELEMENTPOOL_H_INCLUDED
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "element.h"
+#include "compositeelement.h"
+#include "nodearena.h"
+
+/**
+	\class ElementPool
+	\brief Hash-consing table for symbolic element nodes
+
+	Every node is looked up by its structure before it is created: an integer by its value, a
+	variable by its name and a composite by its operation and the addresses of its operands. Operands
+	are themselves pooled, so structurally identical subexpressions are one node, across the whole
+	matrix and across matrices, and memory is proportional to the number of distinct subexpressions.
+	Each node and its reference counts are one block of an arena owned by the pool, and the table
+	holds weak references only. When no matrix uses a node any more the node is destroyed at once,
+	its block stays reserved by the weak reference until the entry is swept or overwritten, which
+	returns the block to the arena. Releasing a node therefore takes no lock and touches no table.
+
+	simplified() builds nodes through the algebraic rules below before pooling them, so that
+	symbolic products of sparse matrices do not keep a node for every multiplication by zero:
+	- operations on two integers are folded
+	- x+0, 0+x, x-0, 1*x and x*1 give x, 0*x and x*0 give 0
+	- a constant factor is kept on the left, c*(d*x) gives (c*d)*x
+	- like terms are collected, (c*x)+(d*x) gives ((c+d)*x) and x-x gives 0
+	- (x+c)+d and (x+c)-d give x+(c+d) and x+(c-d)
+	Every rule holds in wrapping 32-bit arithmetic, so evaluation results do not change.
+*/
+class ElementPool{
+
+private:
+	/**
+		\brief Structure of a node, operands are identified by address
+	*/
+	struct Key{
+		char kind;
+		char op;
+		int value;
+		const Element* left;
+		const Element* right;
+
+		bool operator==(const Key& k) const{
+			return kind == k.kind && op == k.op && value == k.value && left == k.left && right == k.right;
+		}
+	};
+
+	/**
+		\brief Hash of a Key
+	*/
+	struct KeyHash{
+		std::size_t operator()(const Key& k) const;
+	};
+
+	/**
+		\brief Memory of the pooled nodes and their reference counts, declared before the table so
+		that it outlives the weak references
+	*/
+	NodeArena arena;
+	/**
+		\brief Live and expired nodes by structure, expired ones are swept when the table doubles
+	*/
+	std::unordered_map<Key, std::weak_ptr<const Element>, KeyHash> table;
+	/**
+		\brief Guards the table and the counters
+	*/
+	std::mutex mutex;
+	/**
+		\brief Table size that triggers the next sweep of expired entries
+	*/
+	std::size_t sweepAt;
+	/**
+		\brief Lookups that returned an existing node
+	*/
+	std::size_t hits;
+	/**
+		\brief Lookups that created a node
+	*/
+	std::size_t misses;
+	/**
+		\brief Whether the symbolic operators build their nodes through simplified()
+	*/
+	std::atomic<bool> simplifying;
+
+	/**
+		\brief Erases expired entries and returns their blocks to the arena, the mutex must be held
+	*/
+	void sweep();
+	/**
+		\brief Returns the live node with the given structure, or stores and returns make()
+	*/
+	std::shared_ptr<const Element> intern(const Key& key, const std::function<std::shared_ptr<const Element>()>& make);
+
+public:
+	/**
+		\brief Empty constructor
+	*/
+	ElementPool():sweepAt{1024},hits{0},misses{0},simplifying{true}{}
+
+	ElementPool(const ElementPool&) = delete;
+	ElementPool& operator=(const ElementPool&) = delete;
+
+	/**
+		\brief Pooled IntElement
+		\param Value
+		\return Shared node
+	*/
+	std::shared_ptr<const Element> integer(int value);
+
+	/**
+		\brief Pooled VariableElement
+		\param Variable name
+		\return Shared node
+	*/
+	std::shared_ptr<const Element> variable(char name);
+
+	/**
+		\brief Pooled CompositeElement
+		\param First operand
+		\param Second operand
+		\param Operation
+		\return Shared node
+	*/
+	std::shared_ptr<const Element> composite(std::shared_ptr<const Element> e1, std::shared_ptr<const Element> e2, OpCode opc);
+
+	/**
+		\brief Pooled node for e1 op e2 after applying the simplification rules
+		\param First operand, already simplified
+		\param Second operand, already simplified
+		\param Operation
+		\param Set to true if a multiplication by zero discarded an operand that is not an integer,
+		the variables of that operand may then be missing from the result, left alone otherwise
+		\return Shared node, may be an operand itself or an integer
+	*/
+	std::shared_ptr<const Element> simplified(std::shared_ptr<const Element> e1, std::shared_ptr<const Element> e2, OpCode opc,
+											bool* dropped = nullptr);
+
+	/**
+		\brief Turns simplification in the symbolic operators on or off, SymbolicSquareMatrix::simplify applies it later
+		\param Boolean, true to simplify while building
+	*/
+	void setSimplifying(bool enabled){
+		simplifying = enabled;
+	}
+
+	/**
+		\brief Method to check if the symbolic operators simplify the nodes they build
+		\return Boolean, true by default
+	*/
+	bool isSimplifying() const{
+		return simplifying;
+	}
+
+	/**
+		\brief Method to get the number of live pooled nodes, sweeps the expired entries first
+		\return Number of distinct live nodes
+	*/
+	std::size_t getLiveCount();
+
+	/**
+		\brief Method to get the arena bytes held by live pooled nodes, sweeps the expired entries first
+		\return Bytes used, reference counts and size class rounding included
+	*/
+	std::size_t getBytesUsed();
+
+	/**
+		\brief Method to get the number of lookups that found an existing node
+		\return Hit count
+	*/
+	std::size_t getHitCount();
+
+	/**
+		\brief Method to get the number of lookups that created a node
+		\return Miss count
+	*/
+	std::size_t getMissCount();
+
+	/**
+		\brief Process-wide pool used by SymbolicSquareMatrix, never destroyed so that nodes held by static
+		objects can still be released after main returns, a pool must outlive its nodes
+		\return Pool
+	*/
+	static ElementPool& global();
+};
+
+#endif // ELEMENTPOOL_H_INCLUDED
@@ -0,0 +1,129 @@
+/**
+	\file evaluatedmatrix.cpp
+	\brief Code for EvaluatedMatrix class
+*/
+
+#include <algorithm>
+#include <bitset>
+#include <stdexcept>
+#include <utility>
+#include "evaluatedmatrix.h"
+
+EvaluatedMatrix::EvaluatedMatrix(std::shared_ptr<const CompiledMatrix> compiled, const DenseValuation& val)
+								:program(std::move(compiled)),result(program->getSize()),lastUpdateCount{0}{
+	const std::bitset<256> missing = program->getReferencedVariables() & ~val.getPresent();
+	if(missing.any())
+		throw std::out_of_range(unmappedMessage(missing));
+
+	const std::vector<char>& variables = program->getVariables();
+	const std::vector<int>& constants = program->getConstants();
+	const std::vector<CompiledMatrix::Instruction>& code = program->getCode();
+	const std::vector<int>& outputs = program->getOutputs();
+	const std::size_t base = variables.size() + constants.size();
+
+	registers.reserve(program->getRegisterCount());
+	for (char name : variables)
+		registers.push_back(static_cast<unsigned int>(val[name]));
+	for (int c : constants)
+		registers.push_back(static_cast<unsigned int>(c));
+	registers.resize(program->getRegisterCount());
+	for (std::size_t k = 0; k < code.size(); ++k)
+		run(static_cast<int>(k));
+
+	int* out = result.data();
+	for (int o : outputs)
+		*out++ = static_cast<int>(registers[o]);
+
+	// Variable registers each register depends on, propagated in evaluation order
+	std::vector<std::bitset<256>> depends(program->getRegisterCount());
+	for (std::size_t v = 0; v < variables.size(); ++v)
+		depends[v].set(v);
+	dependentCode.resize(variables.size());
+	dependentElements.resize(variables.size());
+	for (std::size_t k = 0; k < code.size(); ++k){
+		std::bitset<256>& d = depends[base + k];
+		d = depends[code[k].left] | depends[code[k].right];
+		for (std::size_t v = 0; v < variables.size(); ++v){
+			if(d.test(v))
+				dependentCode[v].push_back(static_cast<int>(k));
+		}
+	}
+	for (std::size_t e = 0; e < outputs.size(); ++e){
+		for (std::size_t v = 0; v < variables.size(); ++v){
+			if(depends[outputs[e]].test(v))
+				dependentElements[v].push_back(static_cast<int>(e));
+		}
+	}
+}
+
+EvaluatedMatrix::EvaluatedMatrix(const SymbolicSquareMatrix& m, const DenseValuation& val):EvaluatedMatrix(m.getProgram(), val){}
+
+void EvaluatedMatrix::run(int k){
+	const CompiledMatrix::Instruction& instruction = program->getCode()[k];
+	const unsigned int a = registers[instruction.left], b = registers[instruction.right];
+	unsigned int& r = registers[program->getVariables().size() + program->getConstants().size() + k];
+	switch(instruction.op){
+		case OpCode::Add:
+			r = a + b;
+			break;
+		case OpCode::Subtract:
+			r = a - b;
+			break;
+		case OpCode::Multiply:
+			r = a * b;
+			break;
+	}
+}
+
+void EvaluatedMatrix::set(char name, int value){
+	lastUpdateCount = 0;
+	const std::vector<char>& variables = program->getVariables();
+	const auto it = std::find(variables.begin(), variables.end(), name);
+	if(it == variables.end() || registers[it - variables.begin()] == static_cast<unsigned int>(value))
+		return;
+
+	const std::size_t v = it - variables.begin();
+	registers[v] = static_cast<unsigned int>(value);
+	for (int k : dependentCode[v])
+		run(k);
+	const std::vector<int>& outputs = program->getOutputs();
+	for (int e : dependentElements[v])
+		result.data()[e] = static_cast<int>(registers[outputs[e]]);
+	lastUpdateCount = dependentCode[v].size();
+}
+
+void EvaluatedMatrix::update(const DenseValuation& val){
+	const std::bitset<256> missing = program->getReferencedVariables() & ~val.getPresent();
+	if(missing.any())
+		throw std::out_of_range(unmappedMessage(missing));
+
+	const std::vector<char>& variables = program->getVariables();
+	std::vector<std::size_t> changed;
+	for (std::size_t v = 0; v < variables.size(); ++v){
+		if(registers[v] != static_cast<unsigned int>(val[variables[v]]))
+			changed.push_back(v);
+	}
+	if(changed.size() == 1){
+		set(variables[changed[0]], val[variables[changed[0]]]);
+		return;
+	}
+
+	// Several variables, the affected instructions are merged so each runs once and in order
+	std::vector<int> code, elements;
+	for (std::size_t v : changed){
+		registers[v] = static_cast<unsigned int>(val[variables[v]]);
+		code.insert(code.end(), dependentCode[v].begin(), dependentCode[v].end());
+		elements.insert(elements.end(), dependentElements[v].begin(), dependentElements[v].end());
+	}
+	std::sort(code.begin(), code.end());
+	code.erase(std::unique(code.begin(), code.end()), code.end());
+	std::sort(elements.begin(), elements.end());
+	elements.erase(std::unique(elements.begin(), elements.end()), elements.end());
+
+	for (int k : code)
+		run(k);
+	const std::vector<int>& outputs = program->getOutputs();
+	for (int e : elements)
+		result.data()[e] = static_cast<int>(registers[outputs[e]]);
+	lastUpdateCount = code.size();
+}
@@ -0,0 +1,114 @@
+/**
+	\file evaluatedmatrix.h
+	\brief Header for EvaluatedMatrix class
+*/
+
+#ifndef EVALUATEDMATRIX_H_INCLUDED
+#define EVALUATEDMATRIX_H_INCLUDED
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "compiledmatrix.h"
+#include "concretematrix.h"
+#include "elementarymatrix.h"
+#include "valuation.h"
+
+/**
+	\class EvaluatedMatrix
+	\brief A SymbolicSquareMatrix evaluated once and kept up to date as variables change
+
+	Keeps the value of every register of the compiled program, and for every variable the
+	instructions and elements that depend on it. Changing a variable recomputes only those, so
+	the cost of an update follows the part of the matrix the variable reaches.
+*/
+class EvaluatedMatrix{
+
+private:
+	/**
+		\brief Program being evaluated, shared with the matrix it was compiled from
+	*/
+	std::shared_ptr<const CompiledMatrix> program;
+	/**
+		\brief Current value of every register, unsigned so that the arithmetic wraps
+	*/
+	std::vector<unsigned int> registers;
+	/**
+		\brief Instructions depending on each variable register, in evaluation order
+	*/
+	std::vector<std::vector<int>> dependentCode;
+	/**
+		\brief Elements depending on each variable register, as i*n+j
+	*/
+	std::vector<std::vector<int>> dependentElements;
+	/**
+		\brief Current result
+	*/
+	ConcreteSquareMatrix result;
+	/**
+		\brief Instructions run by the last update
+	*/
+	std::size_t lastUpdateCount;
+
+	/**
+		\brief Runs an instruction
+		\param Index of the instruction
+	*/
+	void run(int k);
+
+public:
+	/**
+		\brief Evaluates a compiled program
+		\param Program to evaluate
+		\param Valuation to be used, a Valuation map converts implicitly
+		\throw std::out_of_range naming every variable of the program that is not mapped
+	*/
+	EvaluatedMatrix(std::shared_ptr<const CompiledMatrix> compiled, const DenseValuation& val);
+
+	/**
+		\brief Evaluates a symbolic matrix through its program
+		\param SymbolicSquareMatrix to evaluate
+		\param Valuation to be used, a Valuation map converts implicitly
+		\throw std::out_of_range naming every variable of the matrix that is not mapped
+	*/
+	EvaluatedMatrix(const SymbolicSquareMatrix& m, const DenseValuation& val);
+
+	/**
+		\brief Changes one variable and recomputes what depends on it, variables the matrix does not use are ignored
+		\param Variable name
+		\param New value
+	*/
+	void set(char name, int value);
+
+	/**
+		\brief Changes every variable whose value differs from the valuation and recomputes what depends on them
+		\param Valuation to be used, a Valuation map converts implicitly
+		\throw std::out_of_range naming every variable of the matrix that is not mapped, nothing is changed then
+	*/
+	void update(const DenseValuation& val);
+
+	/**
+		\brief Method to get the current result
+		\return Evaluated matrix
+	*/
+	const ConcreteSquareMatrix& getResult() const{
+		return result;
+	}
+
+	/**
+		\brief Method to get the program being evaluated
+		\return Shared compiled matrix
+	*/
+	const std::shared_ptr<const CompiledMatrix>& getProgram() const{
+		return program;
+	}
+
+	/**
+		\brief Method to get the number of instructions the last set or update recomputed
+		\return Instruction count
+	*/
+	std::size_t getLastUpdateCount() const{
+		return lastUpdateCount;
+	}
+};
+
+#endif // EVALUATEDMATRIX_H_INCLUDED
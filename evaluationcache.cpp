@@ -0,0 +1,91 @@
+/**
+	\file evaluationcache.cpp
+	\brief Code for EvaluationCache class
+*/
+
+#include <bitset>
+#include <stdexcept>
+#include <utility>
+#include "evaluationcache.h"
+
+std::size_t EvaluationCache::KeyHash::operator()(const std::vector<int>& key) const{
+	std::size_t h = key.size();
+	for (int v : key)
+		h ^= std::hash<int>()(v) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+	return h;
+}
+
+ConcreteSquareMatrix EvaluationCache::evaluate(const CompiledMatrix& program, const DenseValuation& val){
+	const std::bitset<256> missing = program.getReferencedVariables() & ~val.getPresent();
+	if(missing.any())
+		throw std::out_of_range(unmappedMessage(missing));
+
+	std::vector<int> key;
+	key.reserve(program.getVariables().size());
+	for (char name : program.getVariables())
+		key.push_back(val[name]);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = index.find(key);
+		if(it != index.end()){
+			++hits;
+			entries.splice(entries.begin(), entries, it->second);
+			return it->second->result;
+		}
+		++misses;
+	}
+
+	// evaluated without the lock, two threads missing the same key both evaluate it
+	ConcreteSquareMatrix result = program.evaluate(key.data());
+	const std::size_t size = static_cast<std::size_t>(result.getSize())*result.getSize();
+	const std::size_t bytes = sizeof(Entry) + 2*key.size()*sizeof(int) + size*sizeof(int) + 4*sizeof(void*);
+	if(bytes > capacity)
+		return result;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if(index.count(key))
+		return result;
+	while(bytesUsed + bytes > capacity){
+		bytesUsed -= entries.back().bytes;
+		index.erase(entries.back().key);
+		entries.pop_back();
+		++evictions;
+	}
+	entries.push_front(Entry{key, result, bytes});
+	index.emplace(std::move(key), entries.begin());
+	bytesUsed += bytes;
+	return result;
+}
+
+void EvaluationCache::clear(){
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	index.clear();
+	bytesUsed = 0;
+}
+
+std::size_t EvaluationCache::getBytesUsed() const{
+	std::lock_guard<std::mutex> lock(mutex);
+	return bytesUsed;
+}
+
+std::size_t EvaluationCache::getEntryCount() const{
+	std::lock_guard<std::mutex> lock(mutex);
+	return entries.size();
+}
+
+std::size_t EvaluationCache::getHitCount() const{
+	std::lock_guard<std::mutex> lock(mutex);
+	return hits;
+}
+
+std::size_t EvaluationCache::getMissCount() const{
+	std::lock_guard<std::mutex> lock(mutex);
+	return misses;
+}
+
+std::size_t EvaluationCache::getEvictionCount() const{
+	std::lock_guard<std::mutex> lock(mutex);
+	return evictions;
+}
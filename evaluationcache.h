@@ -0,0 +1,140 @@
+/**
+	\file evaluationcache.h
+	\brief Header for EvaluationCache class
+*/
+
+#ifndef EVALUATIONCACHE_H_INCLUDED
+#define EVALUATIONCACHE_H_INCLUDED
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "compiledmatrix.h"
+#include "concretematrix.h"
+#include "valuation.h"
+
+/**
+	\class EvaluationCache
+	\brief Bounded least recently used cache of evaluation results of one compiled matrix
+
+	Entries are keyed by the values of the variables the program reads, so valuations differing only
+	in other variables share an entry. When the stored bytes would exceed the capacity the least
+	recently used entries are evicted. Safe to use from several threads.
+*/
+class EvaluationCache{
+
+private:
+	/**
+		\brief Hash of the variable values of a key
+	*/
+	struct KeyHash{
+		std::size_t operator()(const std::vector<int>& key) const;
+	};
+
+	/**
+		\brief Cached result with its key
+	*/
+	struct Entry{
+		std::vector<int> key;
+		ConcreteSquareMatrix result;
+		std::size_t bytes;
+	};
+
+	/**
+		\brief Entries from most to least recently used
+	*/
+	std::list<Entry> entries;
+	/**
+		\brief Entry of each key
+	*/
+	std::unordered_map<std::vector<int>, std::list<Entry>::iterator, KeyHash> index;
+	/**
+		\brief Guards everything below
+	*/
+	mutable std::mutex mutex;
+	/**
+		\brief Maximum number of bytes stored
+	*/
+	std::size_t capacity;
+	/**
+		\brief Bytes stored
+	*/
+	std::size_t bytesUsed;
+	/**
+		\brief Evaluations answered from the cache
+	*/
+	std::size_t hits;
+	/**
+		\brief Evaluations computed
+	*/
+	std::size_t misses;
+	/**
+		\brief Entries evicted to make room
+	*/
+	std::size_t evictions;
+
+public:
+	/**
+		\brief Parametric constructor
+		\param Capacity in bytes, counting the results, the keys and a fixed overhead per entry
+	*/
+	explicit EvaluationCache(std::size_t maxBytes):capacity{maxBytes},bytesUsed{0},hits{0},misses{0},evictions{0}{}
+
+	EvaluationCache(const EvaluationCache&) = delete;
+	EvaluationCache& operator=(const EvaluationCache&) = delete;
+
+	/**
+		\brief Returns the cached result for the valuation, or evaluates the program and caches the result
+		\param Program to evaluate, the same one on every call
+		\param Valuation to be used, a Valuation map converts implicitly
+		\return Resulting ConcreteSquareMatrix
+		\throw std::out_of_range naming every variable of the program that is not mapped
+	*/
+	ConcreteSquareMatrix evaluate(const CompiledMatrix& program, const DenseValuation& val);
+
+	/**
+		\brief Removes every entry, the counters are kept
+	*/
+	void clear();
+
+	/**
+		\brief Method to get the capacity
+		\return Maximum number of bytes stored
+	*/
+	std::size_t getCapacity() const{
+		return capacity;
+	}
+
+	/**
+		\brief Method to get the number of bytes stored
+		\return Bytes used
+	*/
+	std::size_t getBytesUsed() const;
+
+	/**
+		\brief Method to get the number of cached results
+		\return Entry count
+	*/
+	std::size_t getEntryCount() const;
+
+	/**
+		\brief Method to get the number of evaluations answered from the cache
+		\return Hit count
+	*/
+	std::size_t getHitCount() const;
+
+	/**
+		\brief Method to get the number of evaluations computed
+		\return Miss count
+	*/
+	std::size_t getMissCount() const;
+
+	/**
+		\brief Method to get the number of entries evicted to make room
+		\return Eviction count
+	*/
+	std::size_t getEvictionCount() const;
+};
+
+#endif // EVALUATIONCACHE_H_INCLUDED
@@ -0,0 +1,331 @@
+/**
+	\file fixedmatrix.h
+	\brief Header and code for FixedSquareMatrix class
+*/
+
+#ifndef FIXEDMATRIX_H_INCLUDED
+#define FIXEDMATRIX_H_INCLUDED
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "elementarymatrix.h"
+#include "valuation.h"
+
+/**
+	\brief Integers are computed as unsigned, at least as wide as unsigned int, so overflow wraps
+	instead of being undefined, other types are used as they are
+*/
+template <typename T, bool = std::is_integral<T>::value && !std::is_same<T, bool>::value>
+struct FixedArithmetic{
+	using type = T;
+};
+
+template <typename T>
+struct FixedArithmetic<T, true>{
+	using type = decltype(std::declval<typename std::make_unsigned<T>::type>() + 0u);
+};
+
+/**
+	\brief Scalar of the concrete matrix a FixedSquareMatrix<T, N> converts to, int64_t for types wider than int
+*/
+template <typename T>
+using FixedConcreteScalar = typename std::conditional<(sizeof(T) > sizeof(int)), std::int64_t, int>::type;
+
+/**
+	\class FixedSquareMatrix
+	\brief Square matrix whose dimension is a compile-time constant, for small transforms
+
+	Elements are stored inline, every operation is constexpr and fully unrolled through index
+	sequences, and mixing dimensions is a compile error instead of a std::domain_error.
+	Integer arithmetic wraps around like ConcreteSquareMatrix.
+*/
+template <typename T, int N>
+class FixedSquareMatrix{
+
+	static_assert(std::is_arithmetic<T>::value, "FixedSquareMatrix needs an arithmetic element type");
+	static_assert(N > 0, "FixedSquareMatrix needs a positive dimension");
+
+private:
+	/**
+		\brief Type arithmetic on T is done in
+	*/
+	using Wide = typename FixedArithmetic<T>::type;
+	/**
+		\brief Elements stored row by row, element (i,j) is at i*N+j
+	*/
+	T elements[N*N];
+
+	template <std::size_t... K>
+	constexpr FixedSquareMatrix combine(const FixedSquareMatrix& m, bool subtract, std::index_sequence<K...>) const{
+		FixedSquareMatrix result;
+		((result.elements[K] = static_cast<T>(subtract ? static_cast<Wide>(elements[K]) - static_cast<Wide>(m.elements[K])
+													: static_cast<Wide>(elements[K]) + static_cast<Wide>(m.elements[K]))), ...);
+		return result;
+	}
+
+	template <std::size_t... L>
+	constexpr T dot(std::size_t i, std::size_t j, const FixedSquareMatrix& m, std::index_sequence<L...>) const{
+		return static_cast<T>(((static_cast<Wide>(elements[i*N + L]) * static_cast<Wide>(m.elements[L*N + j])) + ...));
+	}
+
+	template <std::size_t... K>
+	constexpr FixedSquareMatrix multiply(const FixedSquareMatrix& m, std::index_sequence<K...>) const{
+		FixedSquareMatrix result;
+		((result.elements[K] = dot(K / N, K % N, m, std::make_index_sequence<N>())), ...);
+		return result;
+	}
+
+	template <std::size_t... K>
+	constexpr FixedSquareMatrix transposed(std::index_sequence<K...>) const{
+		FixedSquareMatrix result;
+		((result.elements[K] = elements[(K % N)*N + K / N]), ...);
+		return result;
+	}
+
+	template <std::size_t... K>
+	constexpr bool equals(const FixedSquareMatrix& m, std::index_sequence<K...>) const{
+		return ((elements[K] == m.elements[K]) && ...);
+	}
+
+public:
+	/**
+		\brief Empty constructor, creates a zero matrix
+	*/
+	constexpr FixedSquareMatrix():elements{}{}
+
+	/**
+		\brief Parametric constructor
+		\param Values row by row
+	*/
+	constexpr explicit FixedSquareMatrix(const T (&values)[N*N]):elements{}{
+		for (int k = 0; k < N*N; ++k){
+			elements[k] = values[k];
+		}
+	}
+
+	/**
+		\brief Converting constructor from a ConcreteSquareMatrix or Concrete64SquareMatrix
+		\param Matrix to copy values from
+		\throw std::domain_error if matrix dimension is not N
+	*/
+	template <typename Scalar>
+	explicit FixedSquareMatrix(const ConcreteMatrix<Scalar>& m):elements{}{
+		if(m.getSize() != N)
+			throw std::domain_error("Matrix dimensions don't match");
+		for (int k = 0; k < N*N; ++k){
+			elements[k] = static_cast<T>(m.data()[k]);
+		}
+	}
+
+	/**
+		\brief Parametric constructor
+		\param Matrix in string form, eg. "[[i11,i12][i21,i22]]"
+		\throw std::invalid_argument if matrix is in wrong format, or not a square matrix
+		\throw std::domain_error if matrix dimension is not N
+	*/
+	explicit FixedSquareMatrix(const std::string& str_m):FixedSquareMatrix(ConcreteMatrix<FixedConcreteScalar<T>>(str_m)){}
+
+	/**
+		\brief Method to get matrix dimension
+		\return N
+	*/
+	constexpr int getSize() const{
+		return N;
+	}
+
+	/**
+		\brief Method to get a single value
+		\param Row index
+		\param Column index
+		\return Value at (i,j)
+	*/
+	constexpr T getVal(int i, int j) const{
+		return elements[i*N + j];
+	}
+
+	/**
+		\brief Method to set a single value
+		\param Row index
+		\param Column index
+		\param Value to store at (i,j)
+	*/
+	constexpr void setVal(int i, int j, T v){
+		elements[i*N + j] = v;
+	}
+
+	/**
+		\brief Method for transposing a matrix
+		\return Transposed matrix
+	*/
+	constexpr FixedSquareMatrix transpose() const{
+		return transposed(std::make_index_sequence<N*N>());
+	}
+
+	/**
+		\brief Operator for FixedSquareMatrix addition
+		\param FixedSquareMatrix to add with
+		\return Result of addition
+	*/
+	constexpr FixedSquareMatrix& operator+=(const FixedSquareMatrix& m){
+		return *this = *this + m;
+	}
+	/**
+		\brief Operator for FixedSquareMatrix subtraction
+		\param FixedSquareMatrix to subtract with
+		\return Result of subtraction
+	*/
+	constexpr FixedSquareMatrix& operator-=(const FixedSquareMatrix& m){
+		return *this = *this - m;
+	}
+	/**
+		\brief Operator for FixedSquareMatrix multiplication
+		\param FixedSquareMatrix to multiply with
+		\return Result of multiplication
+	*/
+	constexpr FixedSquareMatrix& operator*=(const FixedSquareMatrix& m){
+		return *this = *this * m;
+	}
+	/**
+		\brief Operator for FixedSquareMatrix addition
+		\param FixedSquareMatrix to add with
+		\return Result of addition
+	*/
+	constexpr FixedSquareMatrix operator+(const FixedSquareMatrix& m) const{
+		return combine(m, false, std::make_index_sequence<N*N>());
+	}
+	/**
+		\brief Operator for FixedSquareMatrix subtraction
+		\param FixedSquareMatrix to subtract with
+		\return Result of subtraction
+	*/
+	constexpr FixedSquareMatrix operator-(const FixedSquareMatrix& m) const{
+		return combine(m, true, std::make_index_sequence<N*N>());
+	}
+	/**
+		\brief Operator for FixedSquareMatrix multiplication
+		\param FixedSquareMatrix to multiply with
+		\return Result of multiplication
+	*/
+	constexpr FixedSquareMatrix operator*(const FixedSquareMatrix& m) const{
+		return multiply(m, std::make_index_sequence<N*N>());
+	}
+
+	/**
+		\brief Operator for checking if two FixedSquareMatrices are equal
+		\param FixedSquareMatrix to compare to
+		\return Boolean, true if equal, false if not
+	*/
+	constexpr bool operator==(const FixedSquareMatrix& m) const{
+		return equals(m, std::make_index_sequence<N*N>());
+	}
+
+	/**
+		\brief Operator for checking if two FixedSquareMatrices differ
+		\param FixedSquareMatrix to compare to
+		\return Boolean, true if not equal, false if equal
+	*/
+	constexpr bool operator!=(const FixedSquareMatrix& m) const{
+		return !(*this == m);
+	}
+
+	/**
+		\brief Converts into a dynamically sized matrix
+		\tparam Scalar of the result, by default the narrowest of int and int64_t that holds T
+		\return Concrete matrix with the same values
+	*/
+	template <typename Scalar = FixedConcreteScalar<T>>
+	ConcreteMatrix<Scalar> toConcrete() const{
+		ConcreteMatrix<Scalar> m(N);
+		for (int k = 0; k < N*N; ++k){
+			m.data()[k] = static_cast<Scalar>(elements[k]);
+		}
+		return m;
+	}
+
+	/**
+		\brief Evaluating a FixedSquareMatrix gives the matrix itself
+		\param Valuation, unused
+		\return Copy of the matrix
+	*/
+	constexpr FixedSquareMatrix evaluate(const DenseValuation&) const{
+		return *this;
+	}
+
+	/**
+		\brief Prints matrix as string using toString to ostream
+		\param Ostream to output in
+	*/
+	void print(std::ostream& os) const{
+		os << toString();
+	}
+
+	/**
+		\brief Turns matrix into string in format [[i11,i12][i21,i22]]
+		\return String representation
+	*/
+	std::string toString() const{
+		std::stringstream strm;
+
+		strm << "[";
+		for (int i = 0; i < N; ++i){
+			strm << "[";
+			for (int j = 0; j < N; ++j){
+				if(j != 0) strm << ",";
+				strm << elements[i*N + j];
+			}
+			strm << "]";
+		}
+
+		strm << "]";
+		return strm.str();
+	}
+};
+
+/**
+	\brief Output operator
+	\param Ostream to output in
+	\param FixedSquareMatrix to output
+	\return Ostream
+*/
+template <typename T, int N>
+std::ostream& operator<<(std::ostream& os, const FixedSquareMatrix<T, N>& m){
+	os << m.toString();
+	return os;
+}
+
+/**
+	\brief Evaluates a SymbolicSquareMatrix straight into a FixedSquareMatrix, without heap allocation
+	\param SymbolicSquareMatrix to evaluate
+	\param Valuation to be used, a Valuation map converts implicitly
+	\return Resulting FixedSquareMatrix
+	\throw std::domain_error if matrix dimension is not N
+	\throw std::out_of_range naming every variable that is not in the valuation
+*/
+template <int N>
+FixedSquareMatrix<int, N> evaluateFixed(const SymbolicSquareMatrix& m, const DenseValuation& val){
+	if(m.getSize() != N)
+		throw std::domain_error("Matrix dimensions don't match");
+	const std::bitset<256> missing = m.getVariables() & ~val.getPresent();
+	if(missing.any())
+		throw std::out_of_range(unmappedMessage(missing));
+
+	FixedSquareMatrix<int, N> result;
+	for (int i = 0; i < N; ++i){
+		for (int j = 0; j < N; ++j){
+			result.setVal(i, j, m.getElement(i, j).evaluate(val));
+		}
+	}
+	return result;
+}
+
+using Matrix2 = FixedSquareMatrix<int, 2>;
+using Matrix3 = FixedSquareMatrix<int, 3>;
+using Matrix4 = FixedSquareMatrix<int, 4>;
+
+#endif // FIXEDMATRIX_H_INCLUDED
@@ -8,10 +8,12 @@
 #include <ostream>
 #include <sstream>
 #include <map>
+#include <memory>
 #include <stack>
 #include "element.h"
 #include "compositeelement.h"
 #include "elementarymatrix.h"
+#include "evaluatedmatrix.h"
 #include "valuation.h"
 
 int main(int argc, char** argv){
@@ -21,7 +23,8 @@ int main(int argc, char** argv){
 		return result;
 
 	std::stack<ElementarySquareMatrix<Element>> matrixStack;
-	Valuation valuation;
+	DenseValuation valuation;
+	std::unique_ptr<EvaluatedMatrix> evaluated;
 	std::string input;
 	char firstChar;
 	char c;
@@ -45,24 +48,43 @@ int main(int argc, char** argv){
 					std::cout << "Less than 2 matrices in stack, operation not possible" << std::endl;
 					break;
 				}
-				SymbolicSquareMatrix firstMatrix(matrixStack.top());
+				SymbolicSquareMatrix firstMatrix(std::move(matrixStack.top()));
 				matrixStack.pop();
-				SymbolicSquareMatrix secondMatrix(matrixStack.top());
+				SymbolicSquareMatrix secondMatrix(std::move(matrixStack.top()));
 				matrixStack.pop();
 				SymbolicSquareMatrix result;
 				try{
 					if(firstChar == '+')
-						result = firstMatrix + secondMatrix;
+						result = std::move(firstMatrix) + secondMatrix;
 					if(firstChar == '-')
-						result = firstMatrix - secondMatrix;
+						result = std::move(firstMatrix) - secondMatrix;
 					if(firstChar == '*')
-						result = firstMatrix * secondMatrix;
+						result = std::move(firstMatrix) * secondMatrix;
 				}catch(const std::domain_error& e){
 					std::cerr << e.what() << ". Stack cleared, please try again." << std::endl;
 					break;
 				}
 				std::cout << result << std::endl;
-				matrixStack.push(result);
+				matrixStack.push(std::move(result));
+				break;
+			}
+			case '^':{
+				if(matrixStack.empty()){
+					std::cout << "Stack empty" << std::endl;
+					break;
+				}
+				std::stringstream tempStream(input);
+				int exponent;
+				tempStream >> c;
+				tempStream >> exponent;
+				if(tempStream.fail() || !tempStream.eof() || exponent < 0){
+					std::cout << "Invalid exponent, use ^k with k >= 0" << std::endl;
+					break;
+				}
+				SymbolicSquareMatrix result = matrixStack.top().pow(exponent);
+				matrixStack.pop();
+				std::cout << result << std::endl;
+				matrixStack.push(std::move(result));
 				break;
 			}
 			case '=':{
@@ -70,14 +92,18 @@ int main(int argc, char** argv){
 					std::cout << "Stack empty" << std::endl;
 					break;
 				}
-				ConcreteSquareMatrix evaluated;
 				try{
-					evaluated = matrixStack.top().evaluate(valuation);
+					// the same top matrix is only updated for the variables changed since the last =
+					std::shared_ptr<const CompiledMatrix> program = matrixStack.top().getProgram();
+					if(evaluated && evaluated->getProgram() == program)
+						evaluated->update(valuation);
+					else
+						evaluated.reset(new EvaluatedMatrix(program, valuation));
 				}catch(const std::out_of_range& e){
 					std::cerr << e.what() << ", try again" << std::endl;
 					break;
 				}
-				std::cout << evaluated << std::endl;
+				std::cout << evaluated->getResult() << std::endl;
 				break;
 			}
 			default:
@@ -86,7 +112,7 @@ int main(int argc, char** argv){
 					tempStream >> c;
 					tempStream >> c;
 					tempStream >> value;
-					valuation[firstChar] = value;
+					valuation.set(firstChar, value);
 					break;
 				}
 				std::cout << "Invalid input, try again" << std::endl;
@@ -0,0 +1,719 @@
+/**
+	\file matrixkernels.cpp
+	\brief Code for the low level kernels used by ConcreteSquareMatrix
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "matrixkernels.h"
+#include "alignedallocator.h"
+#include "threadpool.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATRIXKERNELS_X86 1
+#include <immintrin.h>
+#else
+#define MATRIXKERNELS_X86 0
+#endif
+
+/*
+	All arithmetic is done on unsigned values so overflow wraps around
+	instead of being undefined, int and unsigned may alias each other,
+	as may int64_t and uint64_t. Wrapping arithmetic is associative, so
+	every instruction set gives bit-identical results.
+
+	32-bit matrices use the dispatched KernelTable<unsigned>. 64-bit
+	matrices, and 32-bit inputs accumulated in 64 bits, use the portable
+	KernelTable<std::uint64_t>: the widening happens while packing, so the
+	inputs stay 32-bit in memory and only the cache resident panels are wide.
+*/
+
+namespace{
+
+/**
+	\brief Depth of a packed panel, one sliver of A and one sliver of B stay in L1
+*/
+constexpr int KC = 256;
+/**
+	\brief Rows of A packed at once, sized for L2, a multiple of every kernel's tile height
+*/
+constexpr int MC = 128;
+/**
+	\brief Columns of B packed at once, sized for L3, a multiple of every kernel's tile width
+*/
+constexpr int NC = 4096;
+/**
+	\brief Largest register tile of any kernel
+*/
+constexpr int MR_MAX = 8;
+constexpr int NR_MAX = 16;
+/**
+	\brief Smallest dimension multiplied across the thread pool
+*/
+constexpr int PARALLEL_MULTIPLY_MIN = 128;
+/**
+	\brief Width of the output tiles handed to each thread, tiles are MC rows high
+*/
+constexpr int PARALLEL_TILE_COLS = 512;
+/**
+	\brief Elements per task in parallel element-wise kernels
+*/
+constexpr std::size_t PARALLEL_ELEMENTWISE_CHUNK = 1 << 16;
+/**
+	\brief Largest block the transpose recursion handles directly, two tiles of 64-bit values fit in L1
+*/
+constexpr int TRANSPOSE_TILE = 32;
+/**
+	\brief Dimension above which the Strassen-Winograd recursion is used
+*/
+std::atomic<int> strassenCrossover{2048};
+
+template <typename T>
+using PackBuffer = std::vector<T, AlignedAllocator<T>>;
+template <typename T>
+using MicroKernelFn = void (*)(int kc, const T* a, const T* b, T* c, int ldc);
+template <typename T>
+using ElementwiseFn = void (*)(std::size_t count, T* dst, const T* x, const T* y);
+
+/**
+	\brief Kernels of one instruction set and word size, the micro kernel computes an mr x nr register tile
+*/
+template <typename T>
+struct KernelTable{
+	KernelIsa isa;
+	int mr;
+	int nr;
+	MicroKernelFn<T> microKernel;
+	ElementwiseFn<T> add;
+	ElementwiseFn<T> subtract;
+};
+
+template <typename T, int MR, int NR>
+void microKernelScalar(int kc, const T* a, const T* b, T* c, int ldc){
+	T acc[MR][NR] = {};
+
+	for (int p = 0; p < kc; ++p){
+		for (int r = 0; r < MR; ++r){
+			const T ar = a[p*MR + r];
+			for (int s = 0; s < NR; ++s){
+				acc[r][s] += ar * b[p*NR + s];
+			}
+		}
+	}
+
+	for (int r = 0; r < MR; ++r){
+		for (int s = 0; s < NR; ++s){
+			c[static_cast<std::size_t>(r)*ldc + s] += acc[r][s];
+		}
+	}
+}
+
+/*
+	Element-wise kernels compute dst = x + y or dst = x - y, dst may be x or y itself, since every
+	element is read before it is written.
+*/
+
+template <typename T, bool Subtract>
+void elementwiseScalar(std::size_t count, T* dst, const T* x, const T* y){
+	for (std::size_t i = 0; i < count; ++i){
+		if(Subtract)
+			dst[i] = x[i] - y[i];
+		else
+			dst[i] = x[i] + y[i];
+	}
+}
+
+#if MATRIXKERNELS_X86
+
+__attribute__((target("sse4.2")))
+void microKernelSse42(int kc, const unsigned* a, const unsigned* b, unsigned* c, int ldc){
+	__m128i acc[4][2];
+	for (int r = 0; r < 4; ++r){
+		acc[r][0] = _mm_setzero_si128();
+		acc[r][1] = _mm_setzero_si128();
+	}
+
+	for (int p = 0; p < kc; ++p){
+		const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + p*8));
+		const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + p*8 + 4));
+		for (int r = 0; r < 4; ++r){
+			const __m128i ar = _mm_set1_epi32(static_cast<int>(a[p*4 + r]));
+			acc[r][0] = _mm_add_epi32(acc[r][0], _mm_mullo_epi32(ar, b0));
+			acc[r][1] = _mm_add_epi32(acc[r][1], _mm_mullo_epi32(ar, b1));
+		}
+	}
+
+	for (int r = 0; r < 4; ++r){
+		__m128i* cRow = reinterpret_cast<__m128i*>(c + static_cast<std::size_t>(r)*ldc);
+		_mm_storeu_si128(cRow, _mm_add_epi32(_mm_loadu_si128(cRow), acc[r][0]));
+		_mm_storeu_si128(cRow + 1, _mm_add_epi32(_mm_loadu_si128(cRow + 1), acc[r][1]));
+	}
+}
+
+template <bool Subtract>
+__attribute__((target("sse4.2")))
+void elementwiseSse42(std::size_t count, unsigned* dst, const unsigned* x, const unsigned* y){
+	std::size_t i = 0;
+	for (; i + 4 <= count; i += 4){
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+		const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), Subtract ? _mm_sub_epi32(a, b) : _mm_add_epi32(a, b));
+	}
+	elementwiseScalar<unsigned, Subtract>(count - i, dst + i, x + i, y + i);
+}
+
+__attribute__((target("avx2")))
+void microKernelAvx2(int kc, const unsigned* a, const unsigned* b, unsigned* c, int ldc){
+	__m256i acc[4][2];
+	for (int r = 0; r < 4; ++r){
+		acc[r][0] = _mm256_setzero_si256();
+		acc[r][1] = _mm256_setzero_si256();
+	}
+
+	for (int p = 0; p < kc; ++p){
+		const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + p*16));
+		const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + p*16 + 8));
+		for (int r = 0; r < 4; ++r){
+			const __m256i ar = _mm256_set1_epi32(static_cast<int>(a[p*4 + r]));
+			acc[r][0] = _mm256_add_epi32(acc[r][0], _mm256_mullo_epi32(ar, b0));
+			acc[r][1] = _mm256_add_epi32(acc[r][1], _mm256_mullo_epi32(ar, b1));
+		}
+	}
+
+	for (int r = 0; r < 4; ++r){
+		__m256i* cRow = reinterpret_cast<__m256i*>(c + static_cast<std::size_t>(r)*ldc);
+		_mm256_storeu_si256(cRow, _mm256_add_epi32(_mm256_loadu_si256(cRow), acc[r][0]));
+		_mm256_storeu_si256(cRow + 1, _mm256_add_epi32(_mm256_loadu_si256(cRow + 1), acc[r][1]));
+	}
+}
+
+template <bool Subtract>
+__attribute__((target("avx2")))
+void elementwiseAvx2(std::size_t count, unsigned* dst, const unsigned* x, const unsigned* y){
+	std::size_t i = 0;
+	for (; i + 8 <= count; i += 8){
+		const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+		const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), Subtract ? _mm256_sub_epi32(a, b) : _mm256_add_epi32(a, b));
+	}
+	elementwiseScalar<unsigned, Subtract>(count - i, dst + i, x + i, y + i);
+}
+
+__attribute__((target("avx512f")))
+void microKernelAvx512(int kc, const unsigned* a, const unsigned* b, unsigned* c, int ldc){
+	__m512i acc[8];
+	for (int r = 0; r < 8; ++r){
+		acc[r] = _mm512_setzero_si512();
+	}
+
+	for (int p = 0; p < kc; ++p){
+		const __m512i b0 = _mm512_loadu_si512(b + p*16);
+		for (int r = 0; r < 8; ++r){
+			const __m512i ar = _mm512_set1_epi32(static_cast<int>(a[p*8 + r]));
+			acc[r] = _mm512_add_epi32(acc[r], _mm512_mullo_epi32(ar, b0));
+		}
+	}
+
+	for (int r = 0; r < 8; ++r){
+		unsigned* cRow = c + static_cast<std::size_t>(r)*ldc;
+		_mm512_storeu_si512(cRow, _mm512_add_epi32(_mm512_loadu_si512(cRow), acc[r]));
+	}
+}
+
+template <bool Subtract>
+__attribute__((target("avx512f")))
+void elementwiseAvx512(std::size_t count, unsigned* dst, const unsigned* x, const unsigned* y){
+	std::size_t i = 0;
+	for (; i + 16 <= count; i += 16){
+		const __m512i a = _mm512_loadu_si512(x + i);
+		const __m512i b = _mm512_loadu_si512(y + i);
+		_mm512_storeu_si512(dst + i, Subtract ? _mm512_sub_epi32(a, b) : _mm512_add_epi32(a, b));
+	}
+	elementwiseScalar<unsigned, Subtract>(count - i, dst + i, x + i, y + i);
+}
+
+#endif
+
+const KernelTable<unsigned>& tableFor(KernelIsa isa){
+	static const KernelTable<unsigned> scalar{KernelIsa::Scalar, 4, 8, microKernelScalar<unsigned, 4, 8>,
+									elementwiseScalar<unsigned, false>, elementwiseScalar<unsigned, true>};
+#if MATRIXKERNELS_X86
+	static const KernelTable<unsigned> sse42{KernelIsa::SSE42, 4, 8, microKernelSse42,
+									elementwiseSse42<false>, elementwiseSse42<true>};
+	static const KernelTable<unsigned> avx2{KernelIsa::AVX2, 4, 16, microKernelAvx2,
+									elementwiseAvx2<false>, elementwiseAvx2<true>};
+	static const KernelTable<unsigned> avx512{KernelIsa::AVX512, 8, 16, microKernelAvx512,
+									elementwiseAvx512<false>, elementwiseAvx512<true>};
+	switch(isa){
+		case KernelIsa::SSE42: return sse42;
+		case KernelIsa::AVX2: return avx2;
+		case KernelIsa::AVX512: return avx512;
+		default: break;
+	}
+#endif
+	return scalar;
+}
+
+std::atomic<const KernelTable<unsigned>*>& activeTable(){
+	static std::atomic<const KernelTable<unsigned>*> table{&tableFor(detectedKernelIsa())};
+	return table;
+}
+
+/**
+	\brief Kernels for 64-bit arithmetic, there is no 64-bit vector multiply below AVX-512DQ
+*/
+const KernelTable<std::uint64_t>& wideTable(){
+	static const KernelTable<std::uint64_t> wide{KernelIsa::Scalar, 4, 8, microKernelScalar<std::uint64_t, 4, 8>,
+									elementwiseScalar<std::uint64_t, false>, elementwiseScalar<std::uint64_t, true>};
+	return wide;
+}
+
+/**
+	\brief Packs an mc x kc block of A into mr-row slivers, each stored column by column, converting to T
+*/
+template <typename In, typename T>
+void packA(int mc, int kc, const In* a, int lda, int mr, T* packed){
+	for (int i = 0; i < mc; i += mr){
+		const int rows = std::min(mr, mc - i);
+		for (int p = 0; p < kc; ++p){
+			for (int r = 0; r < mr; ++r){
+				*packed++ = r < rows ? static_cast<T>(a[static_cast<std::size_t>(i + r)*lda + p]) : T{0};
+			}
+		}
+	}
+}
+
+/**
+	\brief Packs a kc x nc block of B into nr-column slivers, each stored row by row, converting to T
+*/
+template <typename In, typename T>
+void packB(int kc, int nc, const In* b, int ldb, int nr, T* packed){
+	for (int j = 0; j < nc; j += nr){
+		const int cols = std::min(nr, nc - j);
+		for (int p = 0; p < kc; ++p){
+			const In* bRow = b + static_cast<std::size_t>(p)*ldb + j;
+			for (int s = 0; s < nr; ++s){
+				*packed++ = s < cols ? static_cast<T>(bRow[s]) : T{0};
+			}
+		}
+	}
+}
+
+/**
+	\brief Runs the micro kernel over a packed mc x nc block, handling partial edge tiles
+*/
+template <typename T>
+void macroKernel(const KernelTable<T>& kernel, int mc, int nc, int kc,
+				const T* packedA, const T* packedB, T* c, int ldc){
+	const int mr = kernel.mr;
+	const int nr = kernel.nr;
+	T edge[MR_MAX*NR_MAX];
+
+	for (int j = 0; j < nc; j += nr){
+		const int cols = std::min(nr, nc - j);
+		for (int i = 0; i < mc; i += mr){
+			const int rows = std::min(mr, mc - i);
+			T* cTile = c + static_cast<std::size_t>(i)*ldc + j;
+			const T* aSliver = packedA + static_cast<std::size_t>(i)*kc;
+			const T* bSliver = packedB + static_cast<std::size_t>(j)*kc;
+			if(rows == mr && cols == nr){
+				kernel.microKernel(kc, aSliver, bSliver, cTile, ldc);
+				continue;
+			}
+			std::fill(edge, edge + mr*nr, T{0});
+			kernel.microKernel(kc, aSliver, bSliver, edge, nr);
+			for (int r = 0; r < rows; ++r){
+				for (int s = 0; s < cols; ++s){
+					cTile[static_cast<std::size_t>(r)*ldc + s] += edge[r*nr + s];
+				}
+			}
+		}
+	}
+}
+
+/**
+	\brief Computes rows [rowBegin,rowEnd) and columns [colBegin,colEnd) of c += a * b
+*/
+template <typename In, typename T>
+void multiplyRange(const KernelTable<T>& kernel, int n, const In* a, int lda, const In* b, int ldb,
+					T* c, int ldc, int rowBegin, int rowEnd, int colBegin, int colEnd){
+	// panels sized for this range only, a small product packs small panels and nothing outlives the call
+	const int mcMax = std::min(MC, rowEnd - rowBegin);
+	const int ncMax = std::min(NC, colEnd - colBegin);
+	const int kcMax = std::min(KC, n);
+	PackBuffer<T> packedA(static_cast<std::size_t>(mcMax + MR_MAX)*kcMax);
+	PackBuffer<T> packedB(static_cast<std::size_t>(ncMax + NR_MAX)*kcMax);
+
+	for (int jc = colBegin; jc < colEnd; jc += NC){
+		const int nc = std::min(NC, colEnd - jc);
+		for (int pc = 0; pc < n; pc += KC){
+			const int kc = std::min(KC, n - pc);
+			packB(kc, nc, b + static_cast<std::size_t>(pc)*ldb + jc, ldb, kernel.nr, packedB.data());
+			for (int ic = rowBegin; ic < rowEnd; ic += MC){
+				const int mc = std::min(MC, rowEnd - ic);
+				packA(mc, kc, a + static_cast<std::size_t>(ic)*lda + pc, lda, kernel.mr, packedA.data());
+				macroKernel(kernel, mc, nc, kc, packedA.data(), packedB.data(),
+							c + static_cast<std::size_t>(ic)*ldc + jc, ldc);
+			}
+		}
+	}
+}
+
+/**
+	\brief Classical multiplication c += a * b, output tiles split across the thread pool for large n
+*/
+template <typename In, typename T>
+void multiplyClassical(const KernelTable<T>& kernel, int n, const In* a, int lda, const In* b, int ldb,
+						T* c, int ldc){
+	ThreadPool& pool = ThreadPool::global();
+	if(n < PARALLEL_MULTIPLY_MIN || pool.getThreadCount() == 1){
+		multiplyRange(kernel, n, a, lda, b, ldb, c, ldc, 0, n, 0, n);
+		return;
+	}
+
+	const int tileRows = (n + MC - 1) / MC;
+	const int tileCols = (n + PARALLEL_TILE_COLS - 1) / PARALLEL_TILE_COLS;
+	pool.parallelFor(tileRows*tileCols, [&](int tile){
+		const int rowBegin = (tile / tileCols)*MC;
+		const int colBegin = (tile % tileCols)*PARALLEL_TILE_COLS;
+		multiplyRange(kernel, n, a, lda, b, ldb, c, ldc, rowBegin, std::min(n, rowBegin + MC),
+					colBegin, std::min(n, colBegin + PARALLEL_TILE_COLS));
+	});
+}
+
+/**
+	\brief dst = x + y, or dst = x - y, for h x h strided blocks
+*/
+template <typename T>
+void combine(const KernelTable<T>& kernel, bool subtract, int h, T* dst, int ldd,
+			const T* x, int ldx, const T* y, int ldy){
+	for (int i = 0; i < h; ++i){
+		(subtract ? kernel.subtract : kernel.add)(h, dst + static_cast<std::size_t>(i)*ldd,
+												x + static_cast<std::size_t>(i)*ldx, y + static_cast<std::size_t>(i)*ldy);
+	}
+}
+
+/**
+	\brief dst += src, or dst -= src, for h x h strided blocks
+*/
+template <typename T>
+void accumulate(const KernelTable<T>& kernel, bool subtract, int h, T* dst, int ldd, const T* src, int lds){
+	for (int i = 0; i < h; ++i){
+		T* dRow = dst + static_cast<std::size_t>(i)*ldd;
+		(subtract ? kernel.subtract : kernel.add)(h, dRow, dRow, src + static_cast<std::size_t>(i)*lds);
+	}
+}
+
+/**
+	\brief Strassen-Winograd recursion c += a * b, 7 half-size products and 15 block additions per level
+
+	Odd dimensions peel off the last row and column, which are fixed up with O(n^2) work afterwards.
+	Below the crossover the classical kernel is used.
+*/
+template <typename T>
+void strassenAccumulate(const KernelTable<T>& kernel, int crossover, int n, const T* a, int lda,
+						const T* b, int ldb, T* c, int ldc){
+	if(n <= crossover){
+		multiplyClassical(kernel, n, a, lda, b, ldb, c, ldc);
+		return;
+	}
+
+	if(n % 2 == 1){
+		const int m = n - 1;
+		strassenAccumulate(kernel, crossover, m, a, lda, b, ldb, c, ldc);
+		for (int i = 0; i < m; ++i){
+			const T aLast = a[static_cast<std::size_t>(i)*lda + m];
+			T* cRow = c + static_cast<std::size_t>(i)*ldc;
+			const T* bLast = b + static_cast<std::size_t>(m)*ldb;
+			for (int j = 0; j < m; ++j){
+				cRow[j] += aLast * bLast[j];
+			}
+			T sum = 0;
+			for (int l = 0; l < n; ++l){
+				sum += a[static_cast<std::size_t>(i)*lda + l] * b[static_cast<std::size_t>(l)*ldb + m];
+			}
+			cRow[m] += sum;
+		}
+		T* cLast = c + static_cast<std::size_t>(m)*ldc;
+		for (int l = 0; l < n; ++l){
+			const T aml = a[static_cast<std::size_t>(m)*lda + l];
+			const T* bRow = b + static_cast<std::size_t>(l)*ldb;
+			for (int j = 0; j < n; ++j){
+				cLast[j] += aml * bRow[j];
+			}
+		}
+		return;
+	}
+
+	const int h = n / 2;
+	const std::size_t block = static_cast<std::size_t>(h)*h;
+	const T* a11 = a;
+	const T* a12 = a + h;
+	const T* a21 = a + static_cast<std::size_t>(h)*lda;
+	const T* a22 = a21 + h;
+	const T* b11 = b;
+	const T* b12 = b + h;
+	const T* b21 = b + static_cast<std::size_t>(h)*ldb;
+	const T* b22 = b21 + h;
+	T* c11 = c;
+	T* c12 = c + h;
+	T* c21 = c + static_cast<std::size_t>(h)*ldc;
+	T* c22 = c21 + h;
+
+	PackBuffer<T> temps(10*block);
+	T* s1 = temps.data();
+	T* s2 = s1 + block;
+	T* s3 = s2 + block;
+	T* s4 = s3 + block;
+	T* t1 = s4 + block;
+	T* t2 = t1 + block;
+	T* t3 = t2 + block;
+	T* t4 = t3 + block;
+	T* x = t4 + block;
+	T* y = x + block;
+
+	combine(kernel, false, h, s1, h, a21, lda, a22, lda);
+	combine(kernel, true, h, s2, h, s1, h, a11, lda);
+	combine(kernel, true, h, s3, h, a11, lda, a21, lda);
+	combine(kernel, true, h, s4, h, a12, lda, s2, h);
+	combine(kernel, true, h, t1, h, b12, ldb, b11, ldb);
+	combine(kernel, true, h, t2, h, b22, ldb, t1, h);
+	combine(kernel, true, h, t3, h, b22, ldb, b12, ldb);
+	combine(kernel, true, h, t4, h, t2, h, b21, ldb);
+
+	// x = P1 + P6, shared by every output quadrant
+	strassenAccumulate(kernel, crossover, h, a11, lda, b11, ldb, x, h);
+	accumulate(kernel, false, h, c11, ldc, x, h);
+	strassenAccumulate(kernel, crossover, h, a12, lda, b21, ldb, c11, ldc);
+	strassenAccumulate(kernel, crossover, h, s2, h, t2, h, x, h);
+	accumulate(kernel, false, h, c12, ldc, x, h);
+	accumulate(kernel, false, h, c21, ldc, x, h);
+	accumulate(kernel, false, h, c22, ldc, x, h);
+
+	// P7 goes to C21 and C22
+	strassenAccumulate(kernel, crossover, h, s3, h, t3, h, y, h);
+	accumulate(kernel, false, h, c21, ldc, y, h);
+	accumulate(kernel, false, h, c22, ldc, y, h);
+
+	// P5 goes to C12 and C22
+	std::fill(y, y + block, T{0});
+	strassenAccumulate(kernel, crossover, h, s1, h, t1, h, y, h);
+	accumulate(kernel, false, h, c12, ldc, y, h);
+	accumulate(kernel, false, h, c22, ldc, y, h);
+
+	// P3 goes to C12, P4 is subtracted from C21
+	strassenAccumulate(kernel, crossover, h, s4, h, b22, ldb, c12, ldc);
+	std::fill(y, y + block, T{0});
+	strassenAccumulate(kernel, crossover, h, a22, lda, t4, h, y, h);
+	accumulate(kernel, true, h, c21, ldc, y, h);
+}
+
+/**
+	\brief Transposes rows [rowBegin,rowEnd) and columns [colBegin,colEnd) of src into dst, halving the longer side
+*/
+template <typename T>
+void transposeBlock(int n, const T* src, T* dst, int rowBegin, int rowEnd, int colBegin, int colEnd){
+	const int rows = rowEnd - rowBegin;
+	const int cols = colEnd - colBegin;
+	if(rows <= TRANSPOSE_TILE && cols <= TRANSPOSE_TILE){
+		for (int i = rowBegin; i < rowEnd; ++i){
+			const T* srcRow = src + static_cast<std::size_t>(i)*n;
+			for (int j = colBegin; j < colEnd; ++j){
+				dst[static_cast<std::size_t>(j)*n + i] = srcRow[j];
+			}
+		}
+		return;
+	}
+	if(rows >= cols){
+		const int middle = rowBegin + rows/2;
+		transposeBlock(n, src, dst, rowBegin, middle, colBegin, colEnd);
+		transposeBlock(n, src, dst, middle, rowEnd, colBegin, colEnd);
+	}else{
+		const int middle = colBegin + cols/2;
+		transposeBlock(n, src, dst, rowBegin, rowEnd, colBegin, middle);
+		transposeBlock(n, src, dst, rowBegin, rowEnd, middle, colEnd);
+	}
+}
+
+/**
+	\brief Swaps block rows [rowBegin,rowEnd) x columns [colBegin,colEnd) with its mirror image across the diagonal
+*/
+template <typename T>
+void swapMirrored(int n, T* a, int rowBegin, int rowEnd, int colBegin, int colEnd){
+	const int rows = rowEnd - rowBegin;
+	const int cols = colEnd - colBegin;
+	if(rows <= TRANSPOSE_TILE && cols <= TRANSPOSE_TILE){
+		for (int i = rowBegin; i < rowEnd; ++i){
+			T* row = a + static_cast<std::size_t>(i)*n;
+			for (int j = colBegin; j < colEnd; ++j){
+				std::swap(row[j], a[static_cast<std::size_t>(j)*n + i]);
+			}
+		}
+		return;
+	}
+	if(rows >= cols){
+		const int middle = rowBegin + rows/2;
+		swapMirrored(n, a, rowBegin, middle, colBegin, colEnd);
+		swapMirrored(n, a, middle, rowEnd, colBegin, colEnd);
+	}else{
+		const int middle = colBegin + cols/2;
+		swapMirrored(n, a, rowBegin, rowEnd, colBegin, middle);
+		swapMirrored(n, a, rowBegin, rowEnd, middle, colEnd);
+	}
+}
+
+/**
+	\brief Transposes the diagonal block [begin,end) x [begin,end) in place
+*/
+template <typename T>
+void transposeDiagonal(int n, T* a, int begin, int end){
+	if(end - begin <= TRANSPOSE_TILE){
+		for (int i = begin; i < end; ++i){
+			for (int j = i + 1; j < end; ++j){
+				std::swap(a[static_cast<std::size_t>(i)*n + j], a[static_cast<std::size_t>(j)*n + i]);
+			}
+		}
+		return;
+	}
+	const int middle = begin + (end - begin)/2;
+	transposeDiagonal(n, a, begin, middle);
+	transposeDiagonal(n, a, middle, end);
+	swapMirrored(n, a, begin, middle, middle, end);
+}
+
+}
+
+KernelIsa detectedKernelIsa(){
+#if MATRIXKERNELS_X86
+	static const KernelIsa isa = []{
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx512f"))
+			return KernelIsa::AVX512;
+		if(__builtin_cpu_supports("avx2"))
+			return KernelIsa::AVX2;
+		if(__builtin_cpu_supports("sse4.2"))
+			return KernelIsa::SSE42;
+		return KernelIsa::Scalar;
+	}();
+	return isa;
+#else
+	return KernelIsa::Scalar;
+#endif
+}
+
+KernelIsa activeKernelIsa(){
+	return activeTable().load()->isa;
+}
+
+void setKernelIsa(KernelIsa isa){
+	if(isa > detectedKernelIsa())
+		throw std::invalid_argument("Instruction set not supported by this CPU");
+	activeTable().store(&tableFor(isa));
+}
+
+void parallelChunks(std::size_t count, const std::function<void(std::size_t, std::size_t)>& chunk){
+	ThreadPool& pool = ThreadPool::global();
+	if(count < 2*PARALLEL_ELEMENTWISE_CHUNK || pool.getThreadCount() == 1){
+		chunk(0, count);
+		return;
+	}
+
+	const int chunks = static_cast<int>((count + PARALLEL_ELEMENTWISE_CHUNK - 1) / PARALLEL_ELEMENTWISE_CHUNK);
+	pool.parallelFor(chunks, [&](int i){
+		const std::size_t begin = static_cast<std::size_t>(i)*PARALLEL_ELEMENTWISE_CHUNK;
+		chunk(begin, std::min(begin + PARALLEL_ELEMENTWISE_CHUNK, count));
+	});
+}
+
+/**
+	\brief Runs an element-wise kernel over [0,count), split across ThreadPool::global() for large inputs
+*/
+template <typename T, typename Wrapped>
+static void elementwise(ElementwiseFn<Wrapped> fn, std::size_t count, T* dst, const T* x, const T* y){
+	parallelChunks(count, [&](std::size_t begin, std::size_t end){
+		fn(end - begin, reinterpret_cast<Wrapped*>(dst + begin), reinterpret_cast<const Wrapped*>(x + begin),
+			reinterpret_cast<const Wrapped*>(y + begin));
+	});
+}
+
+void addKernel(std::size_t count, int* dst, const int* x, const int* y){
+	elementwise(activeTable().load()->add, count, dst, x, y);
+}
+
+void subtractKernel(std::size_t count, int* dst, const int* x, const int* y){
+	elementwise(activeTable().load()->subtract, count, dst, x, y);
+}
+
+void addKernel(std::size_t count, std::int64_t* dst, const std::int64_t* x, const std::int64_t* y){
+	elementwise(wideTable().add, count, dst, x, y);
+}
+
+void subtractKernel(std::size_t count, std::int64_t* dst, const std::int64_t* x, const std::int64_t* y){
+	elementwise(wideTable().subtract, count, dst, x, y);
+}
+
+void addKernel(std::size_t count, int* dst, const int* src){
+	addKernel(count, dst, dst, src);
+}
+
+void subtractKernel(std::size_t count, int* dst, const int* src){
+	subtractKernel(count, dst, dst, src);
+}
+
+void addKernel(std::size_t count, std::int64_t* dst, const std::int64_t* src){
+	addKernel(count, dst, dst, src);
+}
+
+void subtractKernel(std::size_t count, std::int64_t* dst, const std::int64_t* src){
+	subtractKernel(count, dst, dst, src);
+}
+
+void transposeKernel(int n, const int* src, int* dst){
+	transposeBlock(n, src, dst, 0, n, 0, n);
+}
+
+void transposeKernel(int n, const std::int64_t* src, std::int64_t* dst){
+	transposeBlock(n, src, dst, 0, n, 0, n);
+}
+
+void transposeInPlaceKernel(int n, int* a){
+	transposeDiagonal(n, a, 0, n);
+}
+
+void transposeInPlaceKernel(int n, std::int64_t* a){
+	transposeDiagonal(n, a, 0, n);
+}
+
+int getStrassenCrossover(){
+	return strassenCrossover.load();
+}
+
+void setStrassenCrossover(int n){
+	strassenCrossover.store(std::max(n, 1));
+}
+
+void multiplyAccumulate(int n, const int* a, const int* b, int* c){
+	const KernelTable<unsigned>& kernel = *activeTable().load();
+	const unsigned* ua = reinterpret_cast<const unsigned*>(a);
+	const unsigned* ub = reinterpret_cast<const unsigned*>(b);
+	unsigned* uc = reinterpret_cast<unsigned*>(c);
+
+	strassenAccumulate(kernel, strassenCrossover.load(), n, ua, n, ub, n, uc, n);
+}
+
+void multiplyAccumulate(int n, const std::int64_t* a, const std::int64_t* b, std::int64_t* c){
+	const std::uint64_t* ua = reinterpret_cast<const std::uint64_t*>(a);
+	const std::uint64_t* ub = reinterpret_cast<const std::uint64_t*>(b);
+	std::uint64_t* uc = reinterpret_cast<std::uint64_t*>(c);
+
+	strassenAccumulate(wideTable(), strassenCrossover.load(), n, ua, n, ub, n, uc, n);
+}
+
+void multiplyAccumulate(int n, const int* a, const int* b, std::int64_t* c){
+	multiplyClassical(wideTable(), n, a, n, b, n, reinterpret_cast<std::uint64_t*>(c), n);
+}
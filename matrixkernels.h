@@ -0,0 +1,136 @@
+/**
+	\file matrixkernels.h
+	\brief Header for the low level kernels used by ConcreteSquareMatrix
+*/
+
+#ifndef MATRIXKERNELS_H_INCLUDED
+#define MATRIXKERNELS_H_INCLUDED
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+	\brief Instruction sets the kernels can be dispatched to, ordered from narrowest to widest
+*/
+enum class KernelIsa{
+	Scalar,
+	SSE42,
+	AVX2,
+	AVX512
+};
+
+/**
+	\brief Widest instruction set supported by this CPU, detected with CPUID
+	\return Detected instruction set
+*/
+KernelIsa detectedKernelIsa();
+
+/**
+	\brief Instruction set the kernels currently dispatch to
+	\return Active instruction set, detectedKernelIsa() unless changed with setKernelIsa
+*/
+KernelIsa activeKernelIsa();
+
+/**
+	\brief Forces the kernels to use the given instruction set
+	\param Instruction set to use
+	\throw std::invalid_argument if the CPU does not support it
+*/
+void setKernelIsa(KernelIsa isa);
+
+/**
+	\brief Splits [0,count) into chunks run across ThreadPool::global(), small ranges run inline
+	\param Number of elements
+	\param Called with each [begin,end) chunk, possibly concurrently
+*/
+void parallelChunks(std::size_t count, const std::function<void(std::size_t, std::size_t)>& chunk);
+
+/**
+	\brief Element-wise addition, dst[i] += src[i], split across ThreadPool::global() for large inputs
+	\param Number of elements
+	\param Destination, accumulated into
+	\param Source
+*/
+void addKernel(std::size_t count, int* dst, const int* src);
+void addKernel(std::size_t count, std::int64_t* dst, const std::int64_t* src);
+
+/**
+	\brief Element-wise subtraction, dst[i] -= src[i], split across ThreadPool::global() for large inputs
+	\param Number of elements
+	\param Destination, subtracted from
+	\param Source
+*/
+void subtractKernel(std::size_t count, int* dst, const int* src);
+void subtractKernel(std::size_t count, std::int64_t* dst, const std::int64_t* src);
+
+/**
+	\brief Element-wise sum, dst[i] = x[i] + y[i], split across ThreadPool::global() for large inputs
+	\param Number of elements
+	\param Destination, may be x or y
+	\param First operand
+	\param Second operand
+*/
+void addKernel(std::size_t count, int* dst, const int* x, const int* y);
+void addKernel(std::size_t count, std::int64_t* dst, const std::int64_t* x, const std::int64_t* y);
+
+/**
+	\brief Element-wise difference, dst[i] = x[i] - y[i], split across ThreadPool::global() for large inputs
+	\param Number of elements
+	\param Destination, may be x or y
+	\param Operand subtracted from
+	\param Operand to subtract
+*/
+void subtractKernel(std::size_t count, int* dst, const int* x, const int* y);
+void subtractKernel(std::size_t count, std::int64_t* dst, const std::int64_t* x, const std::int64_t* y);
+
+/**
+	\brief Cache-oblivious transpose, dst = src^T, the matrices are split recursively until the tiles fit in L1
+	\param Dimension n of the n x n matrices
+	\param Row-major source
+	\param Row-major destination, must not alias src
+*/
+void transposeKernel(int n, const int* src, int* dst);
+void transposeKernel(int n, const std::int64_t* src, std::int64_t* dst);
+
+/**
+	\brief Cache-oblivious in-place transpose, diagonal blocks are transposed and mirrored blocks swapped recursively
+	\param Dimension n of the n x n matrix
+	\param Row-major matrix
+*/
+void transposeInPlaceKernel(int n, int* a);
+void transposeInPlaceKernel(int n, std::int64_t* a);
+
+/**
+	\brief Dimension above which multiplyAccumulate uses Strassen-Winograd recursion
+	\return Current crossover
+*/
+int getStrassenCrossover();
+
+/**
+	\brief Sets the dimension above which multiplyAccumulate uses Strassen-Winograd recursion
+	\param New crossover, values below 1 are treated as 1
+*/
+void setStrassenCrossover(int n);
+
+/**
+	\brief Matrix multiplication c += a * b, Strassen-Winograd above the crossover and blocked
+	classical kernels below it, output tiles are split across ThreadPool::global()
+	\param Dimension n of the n x n matrices
+	\param Row-major left operand
+	\param Row-major right operand
+	\param Row-major result, accumulated into, must not alias a or b
+*/
+void multiplyAccumulate(int n, const int* a, const int* b, int* c);
+void multiplyAccumulate(int n, const std::int64_t* a, const std::int64_t* b, std::int64_t* c);
+
+/**
+	\brief Matrix multiplication c += a * b of 32-bit inputs with 64-bit accumulation, the inputs are
+	widened while packing so they keep their 32-bit memory footprint, blocked classical kernels only
+	\param Dimension n of the n x n matrices
+	\param Row-major left operand
+	\param Row-major right operand
+	\param Row-major result, accumulated into
+*/
+void multiplyAccumulate(int n, const int* a, const int* b, std::int64_t* c);
+
+#endif // MATRIXKERNELS_H_INCLUDED
@@ -0,0 +1,63 @@
+/**
+	\file matrixparser.cpp
+	\brief Code for MatrixTokenizer class
+*/
+
+#include <cctype>
+#include "matrixparser.h"
+
+MatrixTokenizer::MatrixTokenizer(const std::string& str_m):matrixstring(str_m),rows{0},column{0},width{0},finished{false}{
+	char c;
+	if(!(matrixstring >> c) || c != '[' || !(matrixstring >> c))
+		throw std::invalid_argument("Not valid square matrix");
+	if(c == ']')
+		finish();
+	else if(c != '[')
+		throw std::invalid_argument("Not valid square matrix");
+}
+
+void MatrixTokenizer::finish(){
+	char c;
+	if(rows != width || matrixstring >> c)
+		throw std::invalid_argument("Not valid square matrix");
+	finished = true;
+}
+
+bool MatrixTokenizer::next(MatrixToken& token){
+	if(finished)
+		return false;
+
+	matrixstring >> std::ws;
+	if(std::isalpha(static_cast<unsigned char>(matrixstring.peek()))){
+		token.isVariable = true;
+		token.name = static_cast<char>(matrixstring.get());
+		token.value = 0;
+	}else{
+		token.isVariable = false;
+		token.name = 0;
+		if(!(matrixstring >> token.value))
+			throw std::invalid_argument("Not valid square matrix");
+	}
+	token.row = rows;
+	token.column = column++;
+
+	char c;
+	if(!(matrixstring >> c) || (c != ',' && c != ']') || (rows > 0 && column > width))
+		throw std::invalid_argument("Not valid square matrix");
+	token.endsRow = c == ']';
+	if(token.endsRow){
+		if(rows == 0)
+			width = column;
+		else if(column != width)
+			throw std::invalid_argument("Not valid square matrix");
+		++rows;
+		column = 0;
+		if(rows > width || !(matrixstring >> c))
+			throw std::invalid_argument("Not valid square matrix");
+		if(c == ']')
+			finish();
+		else if(c != '[')
+			throw std::invalid_argument("Not valid square matrix");
+	}
+	return true;
+}
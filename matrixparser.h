@@ -0,0 +1,117 @@
+/**
+	\file matrixparser.h
+	\brief Header for the tokenizer shared by the matrix string constructors
+*/
+
+#ifndef MATRIXPARSER_H_INCLUDED
+#define MATRIXPARSER_H_INCLUDED
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+/**
+	\brief One element of a matrix string, an integer or a single letter variable, with its position
+*/
+struct MatrixToken{
+	bool isVariable;
+	char name;
+	std::int64_t value;
+	int row;
+	int column;
+	bool endsRow;
+};
+
+/**
+	\class MatrixTokenizer
+	\brief Reads the elements of a matrix string one at a time, validating the shape as it goes
+
+	Only the current element is held, so a matrix type can store the elements it keeps while they are
+	read. A row longer than the first one, or more rows than the first row has elements, fail as soon
+	as they are seen, the final check that the matrix is square is made before the last element is returned.
+*/
+class MatrixTokenizer{
+
+private:
+	/**
+		\brief Remaining input
+	*/
+	std::istringstream matrixstring;
+	/**
+		\brief Rows completed so far
+	*/
+	int rows;
+	/**
+		\brief Elements read in the current row
+	*/
+	int column;
+	/**
+		\brief Length of the first row
+	*/
+	int width;
+	/**
+		\brief Whether the closing bracket of the matrix has been read
+	*/
+	bool finished;
+
+	/**
+		\brief Checks that nothing follows the matrix and that it is square
+	*/
+	void finish();
+
+public:
+	/**
+		\brief Parametric constructor, reads the opening brackets
+		\param Matrix in string form, eg. "[[i11,i12][i21,i22]]", "[]" is the empty matrix
+		\throw std::invalid_argument if the string does not start a matrix
+	*/
+	explicit MatrixTokenizer(const std::string& str_m);
+
+	/**
+		\brief Reads the next element
+		\param Set to the element read
+		\return Boolean, false after the last element
+		\throw std::invalid_argument if matrix is in wrong format, or not a square matrix
+	*/
+	bool next(MatrixToken& token);
+
+	/**
+		\brief Method to get the matrix dimension
+		\return Number of rows read, the dimension n once next returned false
+	*/
+	int getSize() const{
+		return rows;
+	}
+};
+
+/**
+	\brief Passes every element of a matrix string to a visitor, in row-major order
+	\param Matrix in string form, eg. "[[i11,i12][i21,i22]]", "[]" is the empty matrix
+	\param Called with each MatrixToken
+	\return Dimension n of the matrix
+	\throw std::invalid_argument if matrix is in wrong format, or not a square matrix
+*/
+template <typename Visitor>
+int tokenizeMatrix(const std::string& str_m, Visitor&& visit){
+	MatrixTokenizer tokens(str_m);
+	MatrixToken token;
+	while(tokens.next(token))
+		visit(token);
+	return tokens.getSize();
+}
+
+/**
+	\brief Integer value of a token for a matrix of integers
+	\tparam Integer type stored by the matrix
+	\param Token to convert
+	\return Value
+	\throw std::invalid_argument if the token is a variable or does not fit the type
+*/
+template <typename Scalar>
+Scalar tokenValue(const MatrixToken& token){
+	if(token.isVariable || static_cast<Scalar>(token.value) != token.value)
+		throw std::invalid_argument("Not valid square matrix");
+	return static_cast<Scalar>(token.value);
+}
+
+#endif // MATRIXPARSER_H_INCLUDED
@@ -0,0 +1,52 @@
+/**
+	\file nodearena.cpp
+	\brief Code for NodeArena class
+*/
+
+#include <new>
+#include "nodearena.h"
+
+void* NodeArena::allocate(std::size_t size, std::size_t alignment){
+	std::lock_guard<std::mutex> lock(mutex);
+	++allocations;
+	if(size > MAX_SMALL){
+		bytesUsed += size;
+		return ::operator new(size);
+	}
+
+	// every small block is a multiple of the granule from a granule-aligned chunk, so any alignment up to it holds
+	static_cast<void>(alignment);
+	const std::size_t sizeClass = size == 0 ? 0 : (size - 1)/GRANULE;
+	const std::size_t rounded = (sizeClass + 1)*GRANULE;
+	bytesUsed += rounded;
+
+	if(FreeBlock* block = freeLists[sizeClass]){
+		freeLists[sizeClass] = block->next;
+		return block;
+	}
+
+	if(rounded > remaining){
+		chunks.emplace_back(new unsigned char[CHUNK_SIZE]);
+		current = chunks.back().get();
+		remaining = CHUNK_SIZE;
+	}
+	void* result = current;
+	current += rounded;
+	remaining -= rounded;
+	return result;
+}
+
+void NodeArena::deallocate(void* p, std::size_t size){
+	std::lock_guard<std::mutex> lock(mutex);
+	if(size > MAX_SMALL){
+		bytesUsed -= size;
+		::operator delete(p);
+		return;
+	}
+
+	const std::size_t sizeClass = size == 0 ? 0 : (size - 1)/GRANULE;
+	bytesUsed -= (sizeClass + 1)*GRANULE;
+	FreeBlock* block = new(p) FreeBlock;
+	block->next = freeLists[sizeClass];
+	freeLists[sizeClass] = block;
+}
@@ -0,0 +1,206 @@
+/**
+	\file nodearena.h
+	\brief Header for NodeArena and ArenaAllocator classes
+*/
+
+#ifndef NODEARENA_H_INCLUDED
+#define NODEARENA_H_INCLUDED
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+	\class NodeArena
+	\brief Bump allocator for element nodes
+
+	Small requests are rounded up to a multiple of GRANULE bytes and handed out from large chunks.
+	A deallocated small block is pushed on the free list of its size class, a singly-linked list
+	threaded through the blocks themselves, and handed out again by the next allocation of that
+	class. The chunks are released only when the arena is destroyed, so an arena holds at most as
+	many bytes as were in use at its peak, for as long as it lives. Requests larger than MAX_SMALL
+	go to the heap directly. The calls are serialized by a mutex of the arena.
+*/
+class NodeArena{
+
+private:
+	/**
+		\brief Size of a chunk
+	*/
+	static constexpr std::size_t CHUNK_SIZE = 64*1024;
+	/**
+		\brief Size classes are multiples of the granule, which is also the alignment of every small block
+	*/
+	static constexpr std::size_t GRANULE = alignof(std::max_align_t);
+	/**
+		\brief Largest request served from the chunks
+	*/
+	static constexpr std::size_t MAX_SMALL = 512;
+	/**
+		\brief Number of size classes, class c holds blocks of (c+1)*GRANULE bytes
+	*/
+	static constexpr std::size_t SIZE_CLASSES = MAX_SMALL/GRANULE;
+
+	/**
+		\brief Header written over a free block, links it to the next free block of its class
+	*/
+	struct FreeBlock{
+		FreeBlock* next;
+	};
+
+	/**
+		\brief Every chunk allocated so far
+	*/
+	std::vector<std::unique_ptr<unsigned char[]>> chunks;
+	/**
+		\brief Deallocated blocks by size class, reused before the current chunk
+	*/
+	FreeBlock* freeLists[SIZE_CLASSES];
+	/**
+		\brief Next free byte in the current chunk
+	*/
+	unsigned char* current;
+	/**
+		\brief Bytes left in the current chunk
+	*/
+	std::size_t remaining;
+	/**
+		\brief Number of allocations served
+	*/
+	std::size_t allocations;
+	/**
+		\brief Bytes handed out and not deallocated, small requests counted at their rounded size
+	*/
+	std::size_t bytesUsed;
+	/**
+		\brief Guards the chunks, the free lists and the counters
+	*/
+	mutable std::mutex mutex;
+
+public:
+	/**
+		\brief Empty constructor, no memory is reserved until the first allocation
+	*/
+	NodeArena():freeLists{},current{nullptr},remaining{0},allocations{0},bytesUsed{0}{}
+
+	NodeArena(const NodeArena&) = delete;
+	NodeArena& operator=(const NodeArena&) = delete;
+
+	/**
+		\brief Allocates memory from the free list of the size class, or from the current chunk,
+		starting a new chunk when it is full
+		\param Size in bytes
+		\param Alignment, at most alignof(std::max_align_t)
+		\return Pointer to uninitialized memory
+	*/
+	void* allocate(std::size_t size, std::size_t alignment);
+
+	/**
+		\brief Returns a block to the arena for reuse by allocations of the same size class
+		\param Pointer returned by allocate
+		\param Size given to allocate
+	*/
+	void deallocate(void* p, std::size_t size);
+
+	/**
+		\brief Method to get the number of allocations served
+		\return Allocation count
+	*/
+	std::size_t getAllocationCount() const{
+		std::lock_guard<std::mutex> lock(mutex);
+		return allocations;
+	}
+
+	/**
+		\brief Method to get the number of chunks, each one was a single heap allocation
+		\return Chunk count
+	*/
+	std::size_t getChunkCount() const{
+		std::lock_guard<std::mutex> lock(mutex);
+		return chunks.size();
+	}
+
+	/**
+		\brief Method to get the number of bytes handed out and not deallocated
+		\return Bytes used, small requests counted at their rounded size
+	*/
+	std::size_t getBytesUsed() const{
+		std::lock_guard<std::mutex> lock(mutex);
+		return bytesUsed;
+	}
+};
+
+/**
+	\class ArenaAllocator
+	\brief Standard allocator drawing from a NodeArena
+
+	With std::allocate_shared the node and its reference counts are one block of the arena, which
+	goes back on a free list once the node and the last std::weak_ptr to it are gone. The allocator
+	does not own the arena, which must outlive every node and weak reference allocated from it.
+*/
+template <typename T>
+class ArenaAllocator{
+
+public:
+	using value_type = T;
+
+	/**
+		\brief Arena the memory comes from
+	*/
+	NodeArena* arena;
+
+	/**
+		\brief Parametric constructor
+		\param Arena to allocate from
+	*/
+	explicit ArenaAllocator(NodeArena& a):arena(&a){}
+
+	/**
+		\brief Converting constructor used when rebinding, shares the arena
+		\param Allocator to copy the arena from
+	*/
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other):arena(other.arena){}
+
+	/**
+		\brief Allocates memory for count objects of type T
+		\param Number of objects
+		\return Pointer to uninitialized memory
+	*/
+	T* allocate(std::size_t count){
+		return static_cast<T*>(arena->allocate(count*sizeof(T), alignof(T)));
+	}
+
+	/**
+		\brief Returns memory for count objects of type T to the arena for reuse
+		\param Pointer returned by allocate
+		\param Number of objects
+	*/
+	void deallocate(T* p, std::size_t count){
+		arena->deallocate(p, count*sizeof(T));
+	}
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b){
+	return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b){
+	return !(a == b);
+}
+
+/**
+	\brief Creates a node and its reference counts in one arena allocation
+	\param Arena to allocate from, must outlive the node and its weak references
+	\param Constructor arguments of T
+	\return Shared pointer to the node
+*/
+template <typename T, typename... Args>
+std::shared_ptr<T> makeArenaNode(NodeArena& arena, Args&&... args){
+	return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+}
+
+#endif // NODEARENA_H_INCLUDED
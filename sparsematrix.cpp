@@ -0,0 +1,226 @@
+/**
+	\file sparsematrix.cpp
+	\brief Code for SparseSquareMatrix class
+*/
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include "sparsematrix.h"
+#include "matrixparser.h"
+
+SparseSquareMatrix::SparseSquareMatrix(const std::string& str_m):rowStart(1, 0){
+	// zeros are dropped as they are read, memory follows the number of nonzeros
+	n = tokenizeMatrix(str_m, [this](const MatrixToken& token){
+		const int value = tokenValue<int>(token);
+		if(value != 0){
+			columns.push_back(token.column);
+			values.push_back(value);
+		}
+		if(token.endsRow)
+			rowStart.push_back(static_cast<int>(values.size()));
+	});
+}
+
+SparseSquareMatrix::SparseSquareMatrix(const ConcreteSquareMatrix& m):n{m.getSize()},rowStart(1, 0){
+	rowStart.reserve(static_cast<std::size_t>(n) + 1);
+	const int* row = m.data();
+	for (int i = 0; i < n; ++i, row += n){
+		for (int j = 0; j < n; ++j){
+			if(row[j] != 0){
+				columns.push_back(j);
+				values.push_back(row[j]);
+			}
+		}
+		rowStart.push_back(static_cast<int>(values.size()));
+	}
+}
+
+int SparseSquareMatrix::getVal(int i, int j) const{
+	auto first = columns.begin() + rowStart[i];
+	auto last = columns.begin() + rowStart[i + 1];
+	auto it = std::lower_bound(first, last, j);
+	if(it == last || *it != j)
+		return 0;
+	return values[it - columns.begin()];
+}
+
+ConcreteSquareMatrix SparseSquareMatrix::toConcrete() const{
+	ConcreteSquareMatrix m(n);
+	int* out = m.data();
+	for (int i = 0; i < n; ++i, out += n){
+		for (int k = rowStart[i]; k < rowStart[i + 1]; ++k){
+			out[columns[k]] = values[k];
+		}
+	}
+	return m;
+}
+
+SparseSquareMatrix SparseSquareMatrix::transpose() const{
+	SparseSquareMatrix mtemp(n);
+	mtemp.columns.resize(values.size());
+	mtemp.values.resize(values.size());
+
+	for (int column : columns){
+		mtemp.rowStart[column + 1]++;
+	}
+	for (int i = 0; i < n; ++i){
+		mtemp.rowStart[i + 1] += mtemp.rowStart[i];
+	}
+
+	// Rows are visited in order, so every transposed row comes out sorted
+	std::vector<int> next(mtemp.rowStart.begin(), mtemp.rowStart.end() - 1);
+	for (int i = 0; i < n; ++i){
+		for (int k = rowStart[i]; k < rowStart[i + 1]; ++k){
+			const int slot = next[columns[k]]++;
+			mtemp.columns[slot] = i;
+			mtemp.values[slot] = values[k];
+		}
+	}
+	return mtemp;
+}
+
+std::string SparseSquareMatrix::toString() const{
+	std::stringstream strm;
+
+	strm << "[";
+	for (int i = 0; i < n; ++i){
+		strm << "[";
+		int k = rowStart[i];
+		for (int j = 0; j < n; ++j){
+			if(j != 0) strm << ",";
+			if(k < rowStart[i + 1] && columns[k] == j)
+				strm << values[k++];
+			else
+				strm << 0;
+		}
+		strm << "]";
+	}
+
+	strm << "]";
+	return strm.str();
+}
+
+template <bool Subtract>
+SparseSquareMatrix SparseSquareMatrix::merge(const SparseSquareMatrix& m) const{
+	if(n!=m.n)
+		throw std::domain_error("Matrix dimensions don't match");
+
+	SparseSquareMatrix mtemp;
+	mtemp.n = n;
+	mtemp.rowStart.reserve(static_cast<std::size_t>(n) + 1);
+	mtemp.columns.reserve(values.size() + m.values.size());
+	mtemp.values.reserve(values.size() + m.values.size());
+
+	for (int i = 0; i < n; ++i){
+		int k = rowStart[i], l = m.rowStart[i];
+		const int kEnd = rowStart[i + 1], lEnd = m.rowStart[i + 1];
+		while(k < kEnd || l < lEnd){
+			int column;
+			unsigned value;
+			if(l == lEnd || (k < kEnd && columns[k] < m.columns[l])){
+				column = columns[k];
+				value = static_cast<unsigned>(values[k++]);
+			}else if(k == kEnd || m.columns[l] < columns[k]){
+				column = m.columns[l];
+				value = Subtract ? 0u - static_cast<unsigned>(m.values[l++]) : static_cast<unsigned>(m.values[l++]);
+			}else{
+				column = columns[k];
+				value = Subtract ? static_cast<unsigned>(values[k++]) - static_cast<unsigned>(m.values[l++])
+								: static_cast<unsigned>(values[k++]) + static_cast<unsigned>(m.values[l++]);
+			}
+			if(value != 0){
+				mtemp.columns.push_back(column);
+				mtemp.values.push_back(static_cast<int>(value));
+			}
+		}
+		mtemp.rowStart.push_back(static_cast<int>(mtemp.values.size()));
+	}
+	return mtemp;
+}
+
+SparseSquareMatrix SparseSquareMatrix::operator+(const SparseSquareMatrix& m) const{
+	return merge<false>(m);
+}
+
+SparseSquareMatrix SparseSquareMatrix::operator-(const SparseSquareMatrix& m) const{
+	return merge<true>(m);
+}
+
+SparseSquareMatrix& SparseSquareMatrix::operator+=(const SparseSquareMatrix& m){
+	*this = merge<false>(m);
+	return *this;
+}
+
+SparseSquareMatrix& SparseSquareMatrix::operator-=(const SparseSquareMatrix& m){
+	*this = merge<true>(m);
+	return *this;
+}
+
+SparseSquareMatrix SparseSquareMatrix::operator*(const SparseSquareMatrix& m) const{
+	if(n!=m.n)
+		throw std::domain_error("Wrong dimensions for multiplication");
+
+	SparseSquareMatrix mtemp;
+	mtemp.n = n;
+	mtemp.rowStart.reserve(static_cast<std::size_t>(n) + 1);
+
+	// Gustavson's algorithm, each output row is accumulated densely and only touched columns are visited
+	std::vector<unsigned> accumulator(n, 0u);
+	std::vector<bool> touched(n, false);
+	std::vector<int> touchedColumns;
+
+	for (int i = 0; i < n; ++i){
+		for (int k = rowStart[i]; k < rowStart[i + 1]; ++k){
+			const int l = columns[k];
+			const unsigned a = static_cast<unsigned>(values[k]);
+			for (int p = m.rowStart[l]; p < m.rowStart[l + 1]; ++p){
+				const int j = m.columns[p];
+				if(!touched[j]){
+					touched[j] = true;
+					touchedColumns.push_back(j);
+				}
+				accumulator[j] += a * static_cast<unsigned>(m.values[p]);
+			}
+		}
+
+		std::sort(touchedColumns.begin(), touchedColumns.end());
+		for (int j : touchedColumns){
+			if(accumulator[j] != 0){
+				mtemp.columns.push_back(j);
+				mtemp.values.push_back(static_cast<int>(accumulator[j]));
+			}
+			accumulator[j] = 0;
+			touched[j] = false;
+		}
+		touchedColumns.clear();
+		mtemp.rowStart.push_back(static_cast<int>(mtemp.values.size()));
+	}
+	return mtemp;
+}
+
+ConcreteSquareMatrix SparseSquareMatrix::operator*(const ConcreteSquareMatrix& m) const{
+	if(n!=m.getSize())
+		throw std::domain_error("Wrong dimensions for multiplication");
+
+	ConcreteSquareMatrix mtemp(n);
+	const unsigned* b = reinterpret_cast<const unsigned*>(m.data());
+	unsigned* c = reinterpret_cast<unsigned*>(mtemp.data());
+
+	for (int i = 0; i < n; ++i){
+		unsigned* cRow = c + static_cast<std::size_t>(i)*n;
+		for (int k = rowStart[i]; k < rowStart[i + 1]; ++k){
+			const unsigned a = static_cast<unsigned>(values[k]);
+			const unsigned* bRow = b + static_cast<std::size_t>(columns[k])*n;
+			for (int j = 0; j < n; ++j){
+				cRow[j] += a * bRow[j];
+			}
+		}
+	}
+	return mtemp;
+}
+
+std::ostream& operator<<(std::ostream& os, const SparseSquareMatrix& m){
+	os << m.toString();
+	return os;
+}
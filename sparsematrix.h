@@ -0,0 +1,187 @@
+/**
+	\file sparsematrix.h
+	\brief Header for SparseSquareMatrix class
+*/
+
+#ifndef SPARSEMATRIX_H_INCLUDED
+#define SPARSEMATRIX_H_INCLUDED
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "concretematrix.h"
+
+/**
+	\class SparseSquareMatrix
+	\brief Integer square matrix in compressed sparse row (CSR) form, only nonzero values are stored
+
+	Row i holds columns[rowStart[i]] ... columns[rowStart[i+1]-1] in increasing order, with the
+	matching values. Zeros are never stored, also when an operation cancels a value out, so two
+	equal matrices always have the same representation. Arithmetic wraps around like
+	ConcreteSquareMatrix, memory and time scale with the number of nonzeros.
+*/
+class SparseSquareMatrix{
+
+private:
+	/**
+		\brief Integer to store matrix dimension (n x n)
+	*/
+	int n;
+	/**
+		\brief Offset of the first nonzero of each row, n+1 entries, the last one is the nonzero count
+	*/
+	std::vector<int> rowStart;
+	/**
+		\brief Column index of each nonzero, increasing within a row
+	*/
+	std::vector<int> columns;
+	/**
+		\brief Value of each nonzero
+	*/
+	std::vector<int> values;
+
+	/**
+		\brief Element-wise sum or difference, rows are merged in one pass
+	*/
+	template <bool Subtract>
+	SparseSquareMatrix merge(const SparseSquareMatrix& m) const;
+
+public:
+
+	/**
+		\brief Empty constructor
+	*/
+	SparseSquareMatrix():n{0},rowStart(1, 0){}
+
+	/**
+		\brief Parametric constructor, creates a zero matrix
+		\param Matrix dimension
+	*/
+	explicit SparseSquareMatrix(int dim):n{dim},rowStart(static_cast<std::size_t>(dim) + 1, 0){}
+
+	/**
+		\brief Parametric constructor, zeros are dropped while parsing
+		\param Matrix in string form, eg. "[[i11,i12][i21,i22]]"
+		\throw std::invalid_argument if matrix is in wrong format, or not a square matrix
+	*/
+	explicit SparseSquareMatrix(const std::string& str_m);
+
+	/**
+		\brief Converting constructor from a ConcreteSquareMatrix
+		\param Matrix to compress
+	*/
+	explicit SparseSquareMatrix(const ConcreteSquareMatrix& m);
+
+	/**
+		\brief Method to get matrix dimension
+		\return Dimension n of the n x n matrix
+	*/
+	int getSize() const{
+		return n;
+	}
+
+	/**
+		\brief Method to get the number of stored values
+		\return Number of nonzeros
+	*/
+	std::size_t getNonZeros() const{
+		return values.size();
+	}
+
+	/**
+		\brief Method to get a single value, binary search within the row
+		\param Row index
+		\param Column index
+		\return Value at (i,j), 0 if not stored
+	*/
+	int getVal(int i, int j) const;
+
+	/**
+		\brief Converts into a dense matrix
+		\return ConcreteSquareMatrix with the same values
+	*/
+	ConcreteSquareMatrix toConcrete() const;
+
+	/**
+		\brief Method for transposing a matrix, a counting sort over the columns
+		\return Transposed matrix
+	*/
+	SparseSquareMatrix transpose() const;
+
+	/**
+		\brief Operator for checking if two SparseSquareMatrices are equal
+		\param SparseSquareMatrix to compare to
+		\return Boolean, true if equal, false if not
+	*/
+	bool operator==(const SparseSquareMatrix& m) const{
+		return n == m.n && rowStart == m.rowStart && columns == m.columns && values == m.values;
+	}
+
+	/**
+		\brief Prints matrix as string using toString to ostream
+		\param Ostream to output in
+	*/
+	void print(std::ostream& os) const{
+		os << toString();
+	}
+
+	/**
+		\brief Turns matrix into string in format [[i11,i12][i21,i22]], zeros included
+		\return String representation
+	*/
+	std::string toString() const;
+
+	/**
+		\brief Operator for SparseSquareMatrix addition
+		\param SparseSquareMatrix to add with
+		\return Result of addition
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	SparseSquareMatrix operator+(const SparseSquareMatrix& m) const;
+	/**
+		\brief Operator for SparseSquareMatrix subtraction
+		\param SparseSquareMatrix to subtract with
+		\return Result of subtraction
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	SparseSquareMatrix operator-(const SparseSquareMatrix& m) const;
+	/**
+		\brief Operator for SparseSquareMatrix addition
+		\param SparseSquareMatrix to add with
+		\return Result of addition
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	SparseSquareMatrix& operator+=(const SparseSquareMatrix& m);
+	/**
+		\brief Operator for SparseSquareMatrix subtraction
+		\param SparseSquareMatrix to subtract with
+		\return Result of subtraction
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	SparseSquareMatrix& operator-=(const SparseSquareMatrix& m);
+	/**
+		\brief Sparse times sparse multiplication (SpGEMM), row by row with a dense accumulator
+		\param SparseSquareMatrix to multiply with
+		\return Result of multiplication
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	SparseSquareMatrix operator*(const SparseSquareMatrix& m) const;
+	/**
+		\brief Sparse times dense multiplication (SpMM), each nonzero scales one row of m
+		\param ConcreteSquareMatrix to multiply with
+		\return Result of multiplication
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	ConcreteSquareMatrix operator*(const ConcreteSquareMatrix& m) const;
+
+};
+
+/**
+	\brief Output operator
+	\param Ostream to output in
+	\param SparseSquareMatrix to output
+	\return Ostream
+*/
+std::ostream& operator<<(std::ostream& os, const SparseSquareMatrix& m);
+
+#endif // SPARSEMATRIX_H_INCLUDED
@@ -0,0 +1,255 @@
+/**
+	\file structuredmatrix.cpp
+	\brief Code for StructuredSquareMatrix class
+*/
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include "structuredmatrix.h"
+
+/**
+	\brief Lower and upper bandwidth of a shape
+*/
+static std::pair<int, int> bandOf(int dim, MatrixStructure structure){
+	const int full = std::max(dim - 1, 0);
+	switch(structure){
+		case MatrixStructure::Diagonal: return {0, 0};
+		case MatrixStructure::LowerTriangular: return {full, 0};
+		case MatrixStructure::UpperTriangular: return {0, full};
+		case MatrixStructure::Tridiagonal: return {1, 1};
+		default: return {full, full};
+	}
+}
+
+/**
+	\brief Narrowest lower and upper bandwidth holding every nonzero of m
+*/
+static std::pair<int, int> detectBand(const ConcreteSquareMatrix& m){
+	const int n = m.getSize();
+	const int* row = m.data();
+	int lower = 0, upper = 0;
+	for (int i = 0; i < n; ++i, row += n){
+		for (int j = 0; j < i - lower; ++j){
+			if(row[j] != 0){
+				lower = i - j;
+				break;
+			}
+		}
+		for (int j = n - 1; j > i + upper; --j){
+			if(row[j] != 0){
+				upper = j - i;
+				break;
+			}
+		}
+	}
+	return {lower, upper};
+}
+
+StructuredSquareMatrix::StructuredSquareMatrix(int dim, int lower, int upper)
+	:n{dim},lower{std::max(0, std::min(lower, dim - 1))},upper{std::max(0, std::min(upper, dim - 1))},
+	rowStart(static_cast<std::size_t>(dim) + 1, 0){
+	for (int i = 0; i < n; ++i){
+		rowStart[i + 1] = rowStart[i] + (columnEnd(i) - columnBegin(i));
+	}
+	elements.assign(rowStart[n], 0);
+}
+
+StructuredSquareMatrix::StructuredSquareMatrix(int dim, MatrixStructure structure)
+	:StructuredSquareMatrix(dim, bandOf(dim, structure).first, bandOf(dim, structure).second){}
+
+StructuredSquareMatrix::StructuredSquareMatrix(const ConcreteSquareMatrix& m)
+	:StructuredSquareMatrix(m, detectBand(m)){}
+
+StructuredSquareMatrix::StructuredSquareMatrix(const ConcreteSquareMatrix& m, int lower, int upper)
+	:StructuredSquareMatrix(m, std::make_pair(lower, upper)){}
+
+StructuredSquareMatrix::StructuredSquareMatrix(const ConcreteSquareMatrix& m, std::pair<int, int> band)
+	:StructuredSquareMatrix(m.getSize(), band.first, band.second){
+	const int* row = m.data();
+	for (int i = 0; i < n; ++i, row += n){
+		for (int j = 0; j < n; ++j){
+			if(j >= columnBegin(i) && j < columnEnd(i))
+				elements[rowStart[i] + (j - columnBegin(i))] = row[j];
+			else if(row[j] != 0)
+				throw std::invalid_argument("Matrix has nonzeros outside the declared structure");
+		}
+	}
+}
+
+StructuredSquareMatrix::StructuredSquareMatrix(const ConcreteSquareMatrix& m, MatrixStructure structure)
+	:StructuredSquareMatrix(m, bandOf(m.getSize(), structure)){}
+
+StructuredSquareMatrix::StructuredSquareMatrix(const std::string& str_m)
+	:StructuredSquareMatrix(ConcreteSquareMatrix(str_m)){}
+
+MatrixStructure StructuredSquareMatrix::getStructure() const{
+	if(lower == 0 && upper == 0)
+		return MatrixStructure::Diagonal;
+	if(lower == 0)
+		return MatrixStructure::UpperTriangular;
+	if(upper == 0)
+		return MatrixStructure::LowerTriangular;
+	if(lower == 1 && upper == 1)
+		return MatrixStructure::Tridiagonal;
+	return MatrixStructure::Banded;
+}
+
+void StructuredSquareMatrix::setVal(int i, int j, int v){
+	if(j < columnBegin(i) || j >= columnEnd(i))
+		throw std::out_of_range("Element is outside the band");
+	elements[rowStart[i] + (j - columnBegin(i))] = v;
+}
+
+ConcreteSquareMatrix StructuredSquareMatrix::toConcrete() const{
+	ConcreteSquareMatrix m(n);
+	int* out = m.data();
+	for (int i = 0; i < n; ++i, out += n){
+		std::copy(elements.begin() + rowStart[i], elements.begin() + rowStart[i + 1], out + columnBegin(i));
+	}
+	return m;
+}
+
+StructuredSquareMatrix StructuredSquareMatrix::transpose() const{
+	StructuredSquareMatrix mtemp(n, upper, lower);
+	for (int i = 0; i < n; ++i){
+		const int* row = elements.data() + rowStart[i];
+		for (int j = columnBegin(i); j < columnEnd(i); ++j){
+			mtemp.elements[mtemp.rowStart[j] + (i - mtemp.columnBegin(j))] = *row++;
+		}
+	}
+	return mtemp;
+}
+
+bool StructuredSquareMatrix::operator==(const StructuredSquareMatrix& m) const{
+	if(n != m.n)
+		return false;
+	for (int i = 0; i < n; ++i){
+		const int begin = std::min(columnBegin(i), m.columnBegin(i));
+		const int end = std::max(columnEnd(i), m.columnEnd(i));
+		for (int j = begin; j < end; ++j){
+			if(getVal(i, j) != m.getVal(i, j))
+				return false;
+		}
+	}
+	return true;
+}
+
+std::string StructuredSquareMatrix::toString() const{
+	std::stringstream strm;
+
+	strm << "[";
+	for (int i = 0; i < n; ++i){
+		strm << "[";
+		for (int j = 0; j < n; ++j){
+			if(j != 0) strm << ",";
+			strm << getVal(i, j);
+		}
+		strm << "]";
+	}
+
+	strm << "]";
+	return strm.str();
+}
+
+template <bool Subtract>
+StructuredSquareMatrix StructuredSquareMatrix::combine(const StructuredSquareMatrix& m) const{
+	if(n!=m.n)
+		throw std::domain_error("Matrix dimensions don't match");
+
+	StructuredSquareMatrix mtemp(n, std::max(lower, m.lower), std::max(upper, m.upper));
+	unsigned* out = reinterpret_cast<unsigned*>(mtemp.elements.data());
+	for (int i = 0; i < n; ++i){
+		unsigned* outRow = out + mtemp.rowStart[i] - mtemp.columnBegin(i);
+		const int* row = elements.data() + rowStart[i] - columnBegin(i);
+		for (int j = columnBegin(i); j < columnEnd(i); ++j){
+			outRow[j] = static_cast<unsigned>(row[j]);
+		}
+		const int* mRow = m.elements.data() + m.rowStart[i] - m.columnBegin(i);
+		for (int j = m.columnBegin(i); j < m.columnEnd(i); ++j){
+			if(Subtract)
+				outRow[j] -= static_cast<unsigned>(mRow[j]);
+			else
+				outRow[j] += static_cast<unsigned>(mRow[j]);
+		}
+	}
+	return mtemp;
+}
+
+StructuredSquareMatrix StructuredSquareMatrix::operator+(const StructuredSquareMatrix& m) const{
+	return combine<false>(m);
+}
+
+StructuredSquareMatrix StructuredSquareMatrix::operator-(const StructuredSquareMatrix& m) const{
+	return combine<true>(m);
+}
+
+StructuredSquareMatrix StructuredSquareMatrix::operator*(const StructuredSquareMatrix& m) const{
+	if(n!=m.n)
+		throw std::domain_error("Wrong dimensions for multiplication");
+
+	StructuredSquareMatrix mtemp(n, lower + m.lower, upper + m.upper);
+	unsigned* out = reinterpret_cast<unsigned*>(mtemp.elements.data());
+	const unsigned* b = reinterpret_cast<const unsigned*>(m.elements.data());
+	for (int i = 0; i < n; ++i){
+		unsigned* outRow = out + mtemp.rowStart[i] - mtemp.columnBegin(i);
+		const int* row = rowData(i);
+		for (int k = columnBegin(i); k < columnEnd(i); ++k){
+			const unsigned a = static_cast<unsigned>(*row++);
+			const unsigned* bRow = b + m.rowStart[k] - m.columnBegin(k);
+			for (int j = m.columnBegin(k); j < m.columnEnd(k); ++j){
+				outRow[j] += a * bRow[j];
+			}
+		}
+	}
+	return mtemp;
+}
+
+ConcreteSquareMatrix StructuredSquareMatrix::operator*(const ConcreteSquareMatrix& m) const{
+	if(n!=m.getSize())
+		throw std::domain_error("Wrong dimensions for multiplication");
+
+	ConcreteSquareMatrix mtemp(n);
+	const unsigned* b = reinterpret_cast<const unsigned*>(m.data());
+	unsigned* c = reinterpret_cast<unsigned*>(mtemp.data());
+	for (int i = 0; i < n; ++i){
+		unsigned* cRow = c + static_cast<std::size_t>(i)*n;
+		const int* row = rowData(i);
+		for (int k = columnBegin(i); k < columnEnd(i); ++k){
+			const unsigned a = static_cast<unsigned>(*row++);
+			const unsigned* bRow = b + static_cast<std::size_t>(k)*n;
+			for (int j = 0; j < n; ++j){
+				cRow[j] += a * bRow[j];
+			}
+		}
+	}
+	return mtemp;
+}
+
+ConcreteSquareMatrix operator*(const ConcreteSquareMatrix& l, const StructuredSquareMatrix& r){
+	const int n = l.getSize();
+	if(n!=r.getSize())
+		throw std::domain_error("Wrong dimensions for multiplication");
+
+	// Row k of r only has columns [columnBegin(k), columnEnd(k)), so each row of the result costs n * bandwidth
+	ConcreteSquareMatrix mtemp(n);
+	const unsigned* a = reinterpret_cast<const unsigned*>(l.data());
+	unsigned* c = reinterpret_cast<unsigned*>(mtemp.data());
+	for (int i = 0; i < n; ++i){
+		const unsigned* aRow = a + static_cast<std::size_t>(i)*n;
+		unsigned* cRow = c + static_cast<std::size_t>(i)*n;
+		for (int k = 0; k < n; ++k){
+			const unsigned aik = aRow[k];
+			const unsigned* bRow = reinterpret_cast<const unsigned*>(r.rowData(k)) - r.columnBegin(k);
+			for (int j = r.columnBegin(k); j < r.columnEnd(k); ++j){
+				cRow[j] += aik * bRow[j];
+			}
+		}
+	}
+	return mtemp;
+}
+
+std::ostream& operator<<(std::ostream& os, const StructuredSquareMatrix& m){
+	os << m.toString();
+	return os;
+}
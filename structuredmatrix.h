@@ -0,0 +1,289 @@
+/**
+	\file structuredmatrix.h
+	\brief Header for StructuredSquareMatrix class
+*/
+
+#ifndef STRUCTUREDMATRIX_H_INCLUDED
+#define STRUCTUREDMATRIX_H_INCLUDED
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "alignedallocator.h"
+#include "concretematrix.h"
+
+/**
+	\brief Shape of a StructuredSquareMatrix, derived from its lower and upper bandwidth
+*/
+enum class MatrixStructure{
+	Diagonal,
+	LowerTriangular,
+	UpperTriangular,
+	Tridiagonal,
+	Banded
+};
+
+/**
+	\class StructuredSquareMatrix
+	\brief Integer square matrix whose nonzeros lie in a band, stored compactly and multiplied in O(n^2 * bandwidth)
+
+	Element (i,j) is inside the band when i-j <= lower and j-i <= upper. Row i stores only the columns
+	[max(0,i-lower), min(n,i+upper+1)), so a diagonal matrix takes n values and a triangular one
+	n(n+1)/2. Arithmetic wraps around like ConcreteSquareMatrix.
+*/
+class StructuredSquareMatrix{
+
+private:
+	/**
+		\brief Integer to store matrix dimension (n x n)
+	*/
+	int n;
+	/**
+		\brief Number of stored diagonals below the main diagonal
+	*/
+	int lower;
+	/**
+		\brief Number of stored diagonals above the main diagonal
+	*/
+	int upper;
+	/**
+		\brief Offset of each row in elements, n+1 entries
+	*/
+	std::vector<std::size_t> rowStart;
+	/**
+		\brief Band values row by row
+	*/
+	std::vector<int, AlignedAllocator<int>> elements;
+
+	/**
+		\brief Element-wise sum or difference over the union of both bands
+	*/
+	template <bool Subtract>
+	StructuredSquareMatrix combine(const StructuredSquareMatrix& m) const;
+
+	/**
+		\brief Copies m into a band given as (lower, upper)
+	*/
+	StructuredSquareMatrix(const ConcreteSquareMatrix& m, std::pair<int, int> band);
+
+public:
+
+	/**
+		\brief Empty constructor
+	*/
+	StructuredSquareMatrix():n{0},lower{0},upper{0},rowStart(1, 0){}
+
+	/**
+		\brief Parametric constructor, creates a zero band matrix
+		\param Matrix dimension
+		\param Lower bandwidth, clamped to [0,n-1]
+		\param Upper bandwidth, clamped to [0,n-1]
+	*/
+	StructuredSquareMatrix(int dim, int lower, int upper);
+
+	/**
+		\brief Parametric constructor, creates a zero matrix of the given shape
+		\param Matrix dimension
+		\param Shape, Banded is treated as a full matrix
+	*/
+	StructuredSquareMatrix(int dim, MatrixStructure structure);
+
+	/**
+		\brief Converting constructor, the narrowest band holding every nonzero is detected
+		\param Matrix to convert
+	*/
+	explicit StructuredSquareMatrix(const ConcreteSquareMatrix& m);
+
+	/**
+		\brief Converting constructor with a band declared by the caller
+		\param Matrix to convert
+		\param Lower bandwidth
+		\param Upper bandwidth
+		\throw std::invalid_argument if a nonzero lies outside the band
+	*/
+	StructuredSquareMatrix(const ConcreteSquareMatrix& m, int lower, int upper);
+
+	/**
+		\brief Converting constructor with a shape declared by the caller
+		\param Matrix to convert
+		\param Shape, Banded is treated as a full matrix
+		\throw std::invalid_argument if a nonzero lies outside the shape
+	*/
+	StructuredSquareMatrix(const ConcreteSquareMatrix& m, MatrixStructure structure);
+
+	/**
+		\brief Parametric constructor, the band is detected while converting
+		\param Matrix in string form, eg. "[[i11,i12][i21,i22]]"
+		\throw std::invalid_argument if matrix is in wrong format, or not a square matrix
+	*/
+	explicit StructuredSquareMatrix(const std::string& str_m);
+
+	/**
+		\brief Method to get matrix dimension
+		\return Dimension n of the n x n matrix
+	*/
+	int getSize() const{
+		return n;
+	}
+
+	/**
+		\brief Method to get the lower bandwidth
+		\return Number of stored diagonals below the main diagonal
+	*/
+	int getLowerBandwidth() const{
+		return lower;
+	}
+
+	/**
+		\brief Method to get the upper bandwidth
+		\return Number of stored diagonals above the main diagonal
+	*/
+	int getUpperBandwidth() const{
+		return upper;
+	}
+
+	/**
+		\brief Method to get the shape tag
+		\return Diagonal, triangular or tridiagonal when the band allows it, Banded otherwise
+	*/
+	MatrixStructure getStructure() const;
+
+	/**
+		\brief Method to get the number of stored values
+		\return Stored value count, zeros inside the band included
+	*/
+	std::size_t getStoredCount() const{
+		return elements.size();
+	}
+
+	/**
+		\brief First column stored in a row
+		\param Row index
+		\return Column index
+	*/
+	int columnBegin(int i) const{
+		return i > lower ? i - lower : 0;
+	}
+
+	/**
+		\brief One past the last column stored in a row
+		\param Row index
+		\return Column index
+	*/
+	int columnEnd(int i) const{
+		return n - i > upper ? i + upper + 1 : n;
+	}
+
+	/**
+		\brief Raw access to the stored part of a row
+		\param Row index
+		\return Pointer to element (i,columnBegin(i))
+	*/
+	const int* rowData(int i) const{
+		return elements.data() + rowStart[i];
+	}
+
+	/**
+		\brief Method to get a single value
+		\param Row index
+		\param Column index
+		\return Value at (i,j), 0 outside the band
+	*/
+	int getVal(int i, int j) const{
+		if(j < columnBegin(i) || j >= columnEnd(i))
+			return 0;
+		return elements[rowStart[i] + (j - columnBegin(i))];
+	}
+
+	/**
+		\brief Method to set a single value
+		\param Row index
+		\param Column index
+		\param Value to store at (i,j)
+		\throw std::out_of_range if (i,j) is outside the band
+	*/
+	void setVal(int i, int j, int v);
+
+	/**
+		\brief Converts into a dense matrix
+		\return ConcreteSquareMatrix with the same values
+	*/
+	ConcreteSquareMatrix toConcrete() const;
+
+	/**
+		\brief Method for transposing a matrix, the bandwidths swap
+		\return Transposed matrix
+	*/
+	StructuredSquareMatrix transpose() const;
+
+	/**
+		\brief Operator for checking if two StructuredSquareMatrices hold the same values, bands may differ
+		\param StructuredSquareMatrix to compare to
+		\return Boolean, true if equal, false if not
+	*/
+	bool operator==(const StructuredSquareMatrix& m) const;
+
+	/**
+		\brief Prints matrix as string using toString to ostream
+		\param Ostream to output in
+	*/
+	void print(std::ostream& os) const{
+		os << toString();
+	}
+
+	/**
+		\brief Turns matrix into string in format [[i11,i12][i21,i22]], zeros included
+		\return String representation
+	*/
+	std::string toString() const;
+
+	/**
+		\brief Operator for StructuredSquareMatrix addition, the result band is the union of both
+		\param StructuredSquareMatrix to add with
+		\return Result of addition
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	StructuredSquareMatrix operator+(const StructuredSquareMatrix& m) const;
+	/**
+		\brief Operator for StructuredSquareMatrix subtraction, the result band is the union of both
+		\param StructuredSquareMatrix to subtract with
+		\return Result of subtraction
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	StructuredSquareMatrix operator-(const StructuredSquareMatrix& m) const;
+	/**
+		\brief Operator for StructuredSquareMatrix multiplication, bandwidths add up
+		\param StructuredSquareMatrix to multiply with
+		\return Result of multiplication
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	StructuredSquareMatrix operator*(const StructuredSquareMatrix& m) const;
+	/**
+		\brief Structured times dense multiplication, each stored value scales one row of m
+		\param ConcreteSquareMatrix to multiply with
+		\return Result of multiplication
+		\throw std::domain_error if matrix dimensions dont match
+	*/
+	ConcreteSquareMatrix operator*(const ConcreteSquareMatrix& m) const;
+
+};
+
+/**
+	\brief Dense times structured multiplication, each value of l scales one stored row of r
+	\param ConcreteSquareMatrix
+	\param StructuredSquareMatrix to multiply with
+	\return Result of multiplication
+	\throw std::domain_error if matrix dimensions dont match
+*/
+ConcreteSquareMatrix operator*(const ConcreteSquareMatrix& l, const StructuredSquareMatrix& r);
+
+/**
+	\brief Output operator
+	\param Ostream to output in
+	\param StructuredSquareMatrix to output
+	\return Ostream
+*/
+std::ostream& operator<<(std::ostream& os, const StructuredSquareMatrix& m);
+
+#endif // STRUCTUREDMATRIX_H_INCLUDED
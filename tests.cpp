@@ -6,10 +6,22 @@
 #include "element.h"
 #include "compositeelement.h"
 #include "elementarymatrix.h"
+#include "fixedmatrix.h"
+#include "sparsematrix.h"
+#include "structuredmatrix.h"
+#include "elementpool.h"
+#include "compiledmatrix.h"
+#include "evaluatedmatrix.h"
+#include "evaluationcache.h"
+#include "matrixkernels.h"
+#include "threadpool.h"
+#include "matrixparser.h"
 #include <algorithm>
 #include <stdexcept>
 #include <vector>
 #include <sstream>
+#include <cstdint>
+#include <limits>
 
 
 TEST_CASE("IntElement tests", "intelement"){
@@ -63,12 +75,54 @@ TEST_CASE("VariableElement tests", "varelement"){
 	CHECK_THROWS(firstobj.evaluate(valu));
 }
 
+TEST_CASE("DenseValuation tests", "densevaluation"){
+	DenseValuation dense;
+	CHECK_FALSE(dense.contains('x'));
+	CHECK_THROWS_AS(dense.at('x'), std::out_of_range);
+	dense.set('x', 5);
+	dense.set('\xff', -3);
+	CHECK(dense.contains('x'));
+	CHECK(dense.at('x') == 5);
+	CHECK(dense['\xff'] == -3);
+	CHECK(dense.getPresent().count() == 2);
+	dense.erase('x');
+	CHECK_FALSE(dense.contains('x'));
+	CHECK(dense['x'] == 0);
+
+	Valuation valu;
+	valu['a'] = 1;
+	valu['b'] = -2;
+	DenseValuation converted = valu;
+	CHECK(converted.at('a') == 1);
+	CHECK(converted.at('b') == -2);
+	CHECK(converted.getPresent().count() == 2);
+
+	VariableElement variable('b');
+	CHECK(variable.evaluate(converted) == -2);
+	CHECK(variable.evaluate(valu) == -2);
+	SymbolicSquareMatrix m("[[a,b][2,a]]");
+	CHECK(m.evaluate(converted) == m.evaluate(valu));
+	CHECK(m.compile().evaluate(converted) == m.evaluate(valu));
+	converted.erase('a');
+	CHECK_THROWS_AS(m.evaluate(converted), std::out_of_range);
+}
+
 TEST_CASE("CompositeElement tests", "compositeelement"){
 	IntElement firstobj(5);
 	VariableElement secondobj('f');
 
-	CompositeElement first(firstobj, secondobj, std::plus<int>(), '+');
+	CompositeElement first(firstobj, secondobj, OpCode::Add);
 	CHECK(first.toString() == "(5+f)");
+	CHECK(first.getOp() == OpCode::Add);
+
+	Valuation valu;
+	valu['f'] = 3;
+	CHECK(first.evaluate(valu) == 8);
+	CHECK(CompositeElement(firstobj, secondobj, OpCode::Subtract).toString() == "(5-f)");
+	CHECK(CompositeElement(firstobj, secondobj, OpCode::Subtract).evaluate(valu) == 2);
+	CHECK(CompositeElement(firstobj, secondobj, OpCode::Multiply).toString() == "(5*f)");
+	CHECK(CompositeElement(firstobj, secondobj, OpCode::Multiply).evaluate(valu) == 15);
+	CHECK(applyOp(OpCode::Add, std::numeric_limits<int>::max(), 1) == std::numeric_limits<int>::min());
 
 	CompositeElement second(first);
 	CHECK(second == first);
@@ -118,6 +172,410 @@ TEST_CASE("ConcreteSquareMatrix correct tests", "concretematrix_correct"){
 	CHECK(out.str() == "[[3,5,7][1,2,2][4,4,6]][[3,5,7][1,2,2][4,4,6]]");	
 }
 
+TEST_CASE("ConcreteSquareMatrix storage tests", "concretematrix_storage"){
+	ConcreteSquareMatrix zero(3);
+	CHECK(zero.getSize() == 3);
+	CHECK(zero.toString() == "[[0,0,0][0,0,0][0,0,0]]");
+	CHECK(reinterpret_cast<std::uintptr_t>(zero.data()) % CACHE_LINE_SIZE == 0);
+
+	zero.setVal(1, 2, 7);
+	CHECK(zero.getVal(1, 2) == 7);
+	CHECK(zero.data()[1*3 + 2] == 7);
+	CHECK(zero.transpose().getVal(2, 1) == 7);
+
+	ConcreteSquareMatrix parsed("[[0,0,0][0,0,7][0,0,0]]");
+	CHECK(parsed == zero);
+	CHECK(parsed.evaluate(Valuation()) == zero);
+}
+
+static ConcreteSquareMatrix patternMatrix(int n, unsigned seed){
+	ConcreteSquareMatrix m(n);
+	for (int i = 0; i < n; ++i){
+		for (int j = 0; j < n; ++j){
+			seed = seed*1103515245u + 12345u;
+			m.setVal(i, j, static_cast<int>((seed >> 16) % 2001) - 1000);
+		}
+	}
+	return m;
+}
+
+static ConcreteSquareMatrix naiveProduct(const ConcreteSquareMatrix& a, const ConcreteSquareMatrix& b){
+	int n = a.getSize();
+	ConcreteSquareMatrix m(n);
+	for (int i = 0; i < n; ++i){
+		for (int j = 0; j < n; ++j){
+			unsigned sum = 0;
+			for (int l = 0; l < n; ++l){
+				sum += static_cast<unsigned>(a.getVal(i, l)) * static_cast<unsigned>(b.getVal(l, j));
+			}
+			m.setVal(i, j, static_cast<int>(sum));
+		}
+	}
+	return m;
+}
+
+TEST_CASE("ConcreteSquareMatrix blocked multiplication tests", "concretematrix_gemm"){
+	for (int n : {1, 2, 7, 67, 300}){
+		ConcreteSquareMatrix a = patternMatrix(n, 1);
+		ConcreteSquareMatrix b = patternMatrix(n, 2);
+		CHECK(a * b == naiveProduct(a, b));
+		a *= b;
+		CHECK(a == naiveProduct(patternMatrix(n, 1), b));
+	}
+}
+
+TEST_CASE("ConcreteSquareMatrix kernel dispatch tests", "concretematrix_simd"){
+	KernelIsa original = activeKernelIsa();
+	CHECK(original == detectedKernelIsa());
+
+	ConcreteSquareMatrix a = patternMatrix(131, 3);
+	ConcreteSquareMatrix b = patternMatrix(131, 4);
+	a.setVal(0, 0, 2147483647);
+	b.setVal(0, 0, 2147483647);
+
+	setKernelIsa(KernelIsa::Scalar);
+	ConcreteSquareMatrix product = a * b;
+	ConcreteSquareMatrix sum = a + b;
+	ConcreteSquareMatrix difference = a - b;
+	CHECK(product == naiveProduct(a, b));
+
+	for (KernelIsa isa : {KernelIsa::SSE42, KernelIsa::AVX2, KernelIsa::AVX512}){
+		if(isa > detectedKernelIsa()){
+			CHECK_THROWS(setKernelIsa(isa));
+			continue;
+		}
+		setKernelIsa(isa);
+		CHECK(activeKernelIsa() == isa);
+		CHECK(a * b == product);
+		CHECK(a + b == sum);
+		CHECK(a - b == difference);
+		// a single matrix sum or difference is written by the dispatched kernel, the comparison reads the expression
+		ConcreteSquareMatrix materialized = a - b;
+		CHECK(materialized == a - b);
+		materialized = a + b;
+		CHECK(materialized == a + b);
+		ConcreteSquareMatrix right(b);
+		ConcreteSquareMatrix aliased = a - std::move(right);
+		CHECK(aliased == a - b);
+	}
+	setKernelIsa(original);
+}
+
+TEST_CASE("ConcreteSquareMatrix Strassen-Winograd tests", "concretematrix_strassen"){
+	int original = getStrassenCrossover();
+	setStrassenCrossover(16);
+	CHECK(getStrassenCrossover() == 16);
+
+	for (int n : {17, 64, 67, 130}){
+		ConcreteSquareMatrix a = patternMatrix(n, 8);
+		ConcreteSquareMatrix b = patternMatrix(n, 9);
+		a.setVal(n - 1, 0, -2147483647);
+		b.setVal(0, n - 1, 2147483647);
+		CHECK(a * b == naiveProduct(a, b));
+	}
+	setStrassenCrossover(original);
+}
+
+TEST_CASE("ConcreteSquareMatrix transpose tests", "concretematrix_transpose"){
+	for (int n : {0, 1, 5, 33, 100, 257}){
+		ConcreteSquareMatrix a = patternMatrix(n, 41);
+		ConcreteSquareMatrix t = a.transpose();
+		bool mirrored = true;
+		for (int i = 0; i < n; ++i){
+			for (int j = 0; j < n; ++j){
+				mirrored = mirrored && t.getVal(j, i) == a.getVal(i, j);
+			}
+		}
+		CHECK(mirrored);
+
+		ConcreteSquareMatrix inPlace(a);
+		const int* buffer = inPlace.data();
+		CHECK(inPlace.transposeInPlace() == t);
+		CHECK(inPlace.data() == buffer);
+		CHECK(ConcreteSquareMatrix(t).transpose() == a);
+		CHECK(Concrete64SquareMatrix(a).transpose() == Concrete64SquareMatrix(t));
+	}
+
+	SymbolicSquareMatrix s("[[x,1,2][y,3,4][5,z,6]]");
+	SymbolicSquareMatrix st = s.transpose();
+	CHECK(st.toString() == "[[x,y,5][1,3,z][2,4,6]]");
+	CHECK(&st.getElement(1, 0) == &s.getElement(0, 1));
+	CHECK(SymbolicSquareMatrix(s).transpose().toString() == st.toString());
+	CHECK(std::move(st).transpose().toString() == s.toString());
+}
+
+TEST_CASE("ThreadPool tests", "threadpool"){
+	ThreadPool pool(4);
+	CHECK(pool.getThreadCount() == 4);
+
+	std::vector<int> visited(1000, 0);
+	pool.parallelFor(1000, [&](int i){ visited[i]++; });
+	CHECK(std::count(visited.begin(), visited.end(), 1) == 1000);
+
+	CHECK_THROWS(pool.parallelFor(10, [](int i){ if(i == 7) throw std::runtime_error("task"); }));
+	pool.resize(2);
+	CHECK(pool.getThreadCount() == 2);
+	CHECK(ThreadPool::defaultThreadCount() >= 1);
+
+	ThreadPool& global = ThreadPool::global();
+	int original = global.getThreadCount();
+	ConcreteSquareMatrix a = patternMatrix(300, 5);
+	ConcreteSquareMatrix b = patternMatrix(300, 6);
+	ConcreteSquareMatrix big = patternMatrix(400, 7);
+	global.resize(1);
+	ConcreteSquareMatrix serialProduct = a * b;
+	ConcreteSquareMatrix serialSum = big + big;
+	global.resize(5);
+	CHECK(a * b == serialProduct);
+	CHECK(big + big == serialSum);
+	CHECK((big + big) - big == big);
+	global.resize(original);
+}
+
+TEST_CASE("ConcreteSquareMatrix expression template tests", "concretematrix_expression"){
+	ConcreteSquareMatrix a("[[1,2][3,4]]");
+	ConcreteSquareMatrix b("[[5,6][7,8]]");
+	ConcreteSquareMatrix c("[[1,1][1,1]]");
+	ConcreteSquareMatrix d("[[-2,0][0,-2]]");
+
+	ConcreteSquareMatrix fused = a + b - c + d;
+	CHECK(fused.toString() == "[[3,7][9,9]]");
+	CHECK((a + b - c + d).eval() == fused);
+	CHECK(a + b - c + d == fused);
+	CHECK(fused == a + b - c + d);
+	CHECK_FALSE(a + b == a - b);
+
+	ConcreteSquareMatrix aliased(a);
+	aliased = b - aliased;
+	CHECK(aliased.toString() == "[[4,4][4,4]]");
+	aliased += a - c;
+	CHECK(aliased.toString() == "[[4,5][6,7]]");
+	aliased -= (a + a) - c;
+	CHECK(aliased.toString() == "[[3,2][1,0]]");
+
+	ConcreteSquareMatrix resized;
+	resized = a + (b + c);
+	CHECK(resized.toString() == "[[7,9][11,13]]");
+
+	ConcreteSquareMatrix other("[[1]]");
+	CHECK_THROWS_AS(a + other, std::domain_error);
+	CHECK_THROWS_AS((a + b) - other, std::domain_error);
+	CHECK_THROWS_AS(other += a - b, std::domain_error);
+}
+
+TEST_CASE("ConcreteSquareMatrix rvalue operator tests", "concretematrix_rvalue"){
+	ConcreteSquareMatrix a("[[1,2][3,4]]");
+	ConcreteSquareMatrix b("[[5,6][7,8]]");
+
+	ConcreteSquareMatrix left(a);
+	const int* leftBuffer = left.data();
+	ConcreteSquareMatrix sum = std::move(left) + b;
+	CHECK(sum.data() == leftBuffer);
+	CHECK(sum.toString() == "[[6,8][10,12]]");
+
+	ConcreteSquareMatrix right(b);
+	const int* rightBuffer = right.data();
+	ConcreteSquareMatrix difference = a - std::move(right);
+	CHECK(difference.data() == rightBuffer);
+	CHECK(difference.toString() == "[[-4,-4][-4,-4]]");
+
+	CHECK(ConcreteSquareMatrix(a) + ConcreteSquareMatrix(b) == sum);
+	CHECK(ConcreteSquareMatrix(a) - ConcreteSquareMatrix(b) == a - b);
+	CHECK((a * b) + a - b == a * b + (a - b));
+	CHECK(a * b - (a + b) == (a * b) - a - b);
+
+	ConcreteSquareMatrix chained = (a * b) * a * b;
+	CHECK(chained == naiveProduct(naiveProduct(naiveProduct(a, b), a), b));
+	ConcreteSquareMatrix squared(a);
+	squared *= squared;
+	CHECK(squared.toString() == "[[7,10][15,22]]");
+
+	ConcreteSquareMatrix other("[[1]]");
+	CHECK_THROWS_AS(ConcreteSquareMatrix(a) + other, std::domain_error);
+	CHECK_THROWS_AS(ConcreteSquareMatrix(a) * other, std::domain_error);
+}
+
+static Concrete64SquareMatrix naiveWideProduct(const ConcreteSquareMatrix& a, const ConcreteSquareMatrix& b){
+	int n = a.getSize();
+	Concrete64SquareMatrix m(n);
+	for (int i = 0; i < n; ++i){
+		for (int j = 0; j < n; ++j){
+			std::int64_t sum = 0;
+			for (int l = 0; l < n; ++l){
+				sum += static_cast<std::int64_t>(a.getVal(i, l)) * b.getVal(l, j);
+			}
+			m.setVal(i, j, sum);
+		}
+	}
+	return m;
+}
+
+TEST_CASE("Concrete64SquareMatrix and wide accumulation tests", "concretematrix_wide"){
+	Int64Element big(std::int64_t(1) << 40);
+	CHECK((big*Int64Element(4)).getVal() == std::int64_t(1) << 42);
+	CHECK((big-Int64Element(1)).toString() == "1099511627775");
+	CHECK_THROWS_AS(big.evaluate(DenseValuation()), std::out_of_range);
+	CHECK(Int64Element(-7).evaluate(DenseValuation()) == -7);
+
+	ConcreteSquareMatrix narrow("[[100000,2][3,-100000]]");
+	CHECK((narrow*narrow).getVal(0, 0) != 10000000006);
+	Concrete64SquareMatrix wide = narrow.multiplyWide(narrow);
+	CHECK(wide.toString() == "[[10000000006,0][0,10000000006]]");
+	CHECK(Concrete64SquareMatrix(narrow)*Concrete64SquareMatrix(narrow) == wide);
+	CHECK(Concrete64SquareMatrix("[[10000000006,0][0,10000000006]]") == wide);
+	CHECK(ConcreteSquareMatrix(wide).getVal(0, 0) == static_cast<int>(static_cast<std::uint32_t>(10000000006)));
+
+	for (int n : {1, 7, 67, 150}){
+		ConcreteSquareMatrix a = patternMatrix(n, 5);
+		ConcreteSquareMatrix b = patternMatrix(n, 6);
+		for (int i = 0; i < n; ++i){
+			a.setVal(i, i, 2000000);
+		}
+		Concrete64SquareMatrix expected = naiveWideProduct(a, b);
+		CHECK(a.multiplyWide(b) == expected);
+		CHECK(Concrete64SquareMatrix(a)*Concrete64SquareMatrix(b) == expected);
+	}
+
+	int crossover = getStrassenCrossover();
+	setStrassenCrossover(8);
+	ConcreteSquareMatrix a = patternMatrix(37, 7);
+	ConcreteSquareMatrix b = patternMatrix(37, 8);
+	Concrete64SquareMatrix a64(a), b64(b);
+	CHECK(a64*b64 == naiveWideProduct(a, b));
+	setStrassenCrossover(crossover);
+
+	Concrete64SquareMatrix sum = a64 + b64 - a64;
+	CHECK(sum == b64);
+	a64 += b64;
+	a64 -= b64;
+	CHECK(ConcreteSquareMatrix(a64) == a);
+	CHECK_THROWS(a64.multiplyWide(Concrete64SquareMatrix(2)));
+}
+
+static ConcreteSquareMatrix sparsePatternMatrix(int n, unsigned seed){
+	ConcreteSquareMatrix m = patternMatrix(n, seed);
+	for (int i = 0; i < n; ++i){
+		for (int j = 0; j < n; ++j){
+			if(m.getVal(i, j) % 20 != 0)
+				m.setVal(i, j, 0);
+		}
+	}
+	return m;
+}
+
+TEST_CASE("SparseSquareMatrix tests", "sparsematrix"){
+	SparseSquareMatrix parsed("[[0,2,0][0,0,0][-3,0,4]]");
+	CHECK(parsed.getSize() == 3);
+	CHECK(parsed.getNonZeros() == 3);
+	CHECK(parsed.getVal(0, 1) == 2);
+	CHECK(parsed.getVal(1, 1) == 0);
+	CHECK(parsed.getVal(2, 2) == 4);
+	CHECK(parsed.toString() == "[[0,2,0][0,0,0][-3,0,4]]");
+	CHECK(parsed.transpose().toString() == "[[0,0,-3][2,0,0][0,0,4]]");
+	CHECK((parsed - parsed).getNonZeros() == 0);
+	CHECK(parsed + parsed == SparseSquareMatrix("[[0,4,0][0,0,0][-6,0,8]]"));
+	CHECK(SparseSquareMatrix(parsed.toConcrete()) == parsed);
+	CHECK_THROWS(SparseSquareMatrix("[[0,1][0]]"));
+	CHECK_THROWS(SparseSquareMatrix("[[0,1][0,2]"));
+	CHECK_THROWS(parsed + SparseSquareMatrix(2));
+	CHECK_THROWS(parsed * SparseSquareMatrix(2));
+
+	for (int n : {1, 7, 67}){
+		ConcreteSquareMatrix a = sparsePatternMatrix(n, 11);
+		ConcreteSquareMatrix b = sparsePatternMatrix(n, 12);
+		ConcreteSquareMatrix dense = patternMatrix(n, 13);
+		SparseSquareMatrix sa(a), sb(b);
+		CHECK(SparseSquareMatrix(a.toString()) == sa);
+		CHECK((sa * sb).toConcrete() == a * b);
+		CHECK(sa * dense == a * dense);
+		CHECK((sa + sb).toConcrete() == ConcreteSquareMatrix(a + b));
+		CHECK((sa - sb).toConcrete() == ConcreteSquareMatrix(a - b));
+		CHECK(sa.transpose().toConcrete() == a.transpose());
+		sa -= sb;
+		sa += sb;
+		CHECK(sa.toConcrete() == a);
+	}
+}
+
+TEST_CASE("StructuredSquareMatrix tests", "structuredmatrix"){
+	StructuredSquareMatrix diagonal("[[2,0,0][0,-3,0][0,0,4]]");
+	CHECK(diagonal.getStructure() == MatrixStructure::Diagonal);
+	CHECK(diagonal.getStoredCount() == 3);
+	CHECK(StructuredSquareMatrix("[[1,0,0][2,3,0][4,5,6]]").getStructure() == MatrixStructure::LowerTriangular);
+	CHECK(StructuredSquareMatrix("[[1,2,3][0,4,5][0,0,6]]").getStoredCount() == 6);
+	CHECK(StructuredSquareMatrix("[[1,2,0][3,4,5][0,6,7]]").getStructure() == MatrixStructure::Tridiagonal);
+	CHECK(StructuredSquareMatrix("[[1,0,3][0,4,0][0,0,7]]").getStructure() == MatrixStructure::UpperTriangular);
+	CHECK(StructuredSquareMatrix("[[1,0,3][0,4,0][5,6,7]]").getStructure() == MatrixStructure::Banded);
+
+	ConcreteSquareMatrix dense("[[1,2,3][4,5,6][7,8,9]]");
+	CHECK((dense * diagonal).toString() == "[[2,-6,12][8,-15,24][14,-24,36]]");
+	CHECK((diagonal * dense).toString() == "[[2,4,6][-12,-15,-18][28,32,36]]");
+	CHECK_THROWS(StructuredSquareMatrix(dense, MatrixStructure::UpperTriangular));
+	CHECK_THROWS(diagonal.setVal(0, 1, 5));
+	CHECK_THROWS(diagonal * ConcreteSquareMatrix(2));
+	CHECK_THROWS(diagonal + StructuredSquareMatrix(2, MatrixStructure::Diagonal));
+
+	for (int n : {1, 8, 67}){
+		ConcreteSquareMatrix a = patternMatrix(n, 21);
+		ConcreteSquareMatrix b = patternMatrix(n, 22);
+		StructuredSquareMatrix lowerBand(n, 2, 0), band(n, 1, 3);
+		for (int i = 0; i < n; ++i){
+			for (int j = 0; j < n; ++j){
+				if(j >= lowerBand.columnBegin(i) && j < lowerBand.columnEnd(i))
+					lowerBand.setVal(i, j, a.getVal(i, j));
+				if(j >= band.columnBegin(i) && j < band.columnEnd(i))
+					band.setVal(i, j, b.getVal(i, j));
+			}
+		}
+		ConcreteSquareMatrix lowerDense = lowerBand.toConcrete(), bandDense = band.toConcrete();
+		CHECK(StructuredSquareMatrix(lowerDense) == lowerBand);
+		CHECK((lowerBand * band).toConcrete() == lowerDense * bandDense);
+		CHECK((lowerBand + band).toConcrete() == ConcreteSquareMatrix(lowerDense + bandDense));
+		CHECK((lowerBand - band).toConcrete() == ConcreteSquareMatrix(lowerDense - bandDense));
+		CHECK(band.transpose().toConcrete() == bandDense.transpose());
+		CHECK(band * a == bandDense * a);
+		CHECK(a * band == a * bandDense);
+	}
+}
+
+TEST_CASE("Matrix tokenizer tests", "matrixparser"){
+	const auto ignore = [](const MatrixToken&){};
+	CHECK(tokenizeMatrix("[]", ignore) == 0);
+	std::vector<MatrixToken> tokens;
+	CHECK(tokenizeMatrix(" [ [x, -3] [ 10000000006 ,y ] ] ", [&tokens](const MatrixToken& token){ tokens.push_back(token); }) == 2);
+	REQUIRE(tokens.size() == 4);
+	CHECK(tokens[0].isVariable);
+	CHECK(tokens[0].name == 'x');
+	CHECK_FALSE(tokens[0].endsRow);
+	CHECK_FALSE(tokens[1].isVariable);
+	CHECK(tokens[1].value == -3);
+	CHECK(tokens[1].endsRow);
+	CHECK(tokens[2].value == 10000000006);
+	CHECK(tokens[2].row == 1);
+	CHECK(tokens[2].column == 0);
+	CHECK(tokens[3].name == 'y');
+	CHECK(tokens[3].column == 1);
+	CHECK(tokens[3].endsRow);
+
+	CHECK(tokenValue<int>(tokens[1]) == -3);
+	CHECK(tokenValue<std::int64_t>(tokens[2]) == 10000000006);
+	CHECK_THROWS_AS(tokenValue<int>(tokens[2]), std::invalid_argument);
+	CHECK_THROWS_AS(tokenValue<int>(tokens[0]), std::invalid_argument);
+
+	CHECK_THROWS_AS(tokenizeMatrix("[[1,2]]", ignore), std::invalid_argument);
+	CHECK_THROWS_AS(tokenizeMatrix("[[1][2,3]]", ignore), std::invalid_argument);
+	CHECK_THROWS_AS(tokenizeMatrix("[[1,]]", ignore), std::invalid_argument);
+	CHECK_THROWS_AS(tokenizeMatrix("[[xy]]", ignore), std::invalid_argument);
+	CHECK_THROWS_AS(tokenizeMatrix("[[1]", ignore), std::invalid_argument);
+	CHECK_THROWS_AS(tokenizeMatrix("[[1]]]", ignore), std::invalid_argument);
+
+	// an over-long column is rejected before the rest of the string is read
+	int visited = 0;
+	CHECK_THROWS_AS(tokenizeMatrix("[[1][2][3]]", [&visited](const MatrixToken&){ ++visited; }), std::invalid_argument);
+	CHECK(visited == 1);
+	CHECK(SparseSquareMatrix("[[0,2][0,0]]").getNonZeros() == 1);
+}
+
 TEST_CASE("ConcreteSquareMatrix incorrect tests and exceptions", "concretematrix_incorrect"){
 	CHECK_NOTHROW(ConcreteSquareMatrix("[]"));
 	CHECK_NOTHROW(ConcreteSquareMatrix("[[1]]"));
@@ -143,6 +601,44 @@ TEST_CASE("ConcreteSquareMatrix incorrect tests and exceptions", "concretematrix
 	CHECK_THROWS(matrixOne-=matrixTwo);
 }
 
+TEST_CASE("FixedSquareMatrix tests", "fixedmatrix"){
+	constexpr Matrix2 a({1, 2, 3, 4});
+	constexpr Matrix2 b({5, 6, 7, 8});
+	static_assert((a * b).getVal(0, 0) == 19, "product is computed at compile time");
+	static_assert(a + b - b == a, "addition and subtraction are constexpr");
+	static_assert(a.transpose().getVal(0, 1) == 3, "transpose is constexpr");
+	static_assert(a.getSize() == 2, "dimension is a constant");
+
+	CHECK((a * b).toString() == "[[19,22][43,50]]");
+	CHECK((a * b).toConcrete() == a.toConcrete() * b.toConcrete());
+	CHECK(Matrix2(ConcreteSquareMatrix("[[1,2][3,4]]")) == a);
+	CHECK(Matrix3("[[3,5,7][1,2,2][4,4,6]]").transpose() == Matrix3("[[3,1,4][5,2,4][7,2,6]]"));
+	CHECK_THROWS_AS(Matrix3(ConcreteSquareMatrix("[[1,2][3,4]]")), std::domain_error);
+
+	Matrix4 identity;
+	for (int i = 0; i < 4; ++i) identity.setVal(i, i, 1);
+	Matrix4 m = identity + identity;
+	m *= m;
+	m -= identity;
+	CHECK(m.getVal(2, 2) == 3);
+	CHECK(m.getVal(2, 1) == 0);
+
+	Matrix2 wrap({2147483647, 0, 0, 1});
+	CHECK((wrap + wrap).toConcrete() == wrap.toConcrete() + wrap.toConcrete());
+	FixedSquareMatrix<short, 2> narrow({-32768, 1, 1, 1});
+	CHECK((narrow * narrow).getVal(0, 0) == 1);
+
+	Valuation valu;
+	valu['x'] = 3;
+	SymbolicSquareMatrix symbolic("[[x,2][3,x]]");
+	Matrix2 evaluated = evaluateFixed<2>(symbolic, valu);
+	CHECK(evaluated.toString() == "[[3,2][3,3]]");
+	CHECK(evaluated.toConcrete() == symbolic.evaluate(valu));
+	CHECK_THROWS_AS(evaluateFixed<3>(symbolic, valu), std::domain_error);
+	valu.erase('x');
+	CHECK_THROWS_AS(evaluateFixed<2>(symbolic, valu), std::out_of_range);
+}
+
 TEST_CASE("SymbolicSquareMatrix correct tests", "Symbolicmatrix_correct"){
 	SymbolicSquareMatrix firstMatrix("[[x,5,7][1,y,2][z,4,6]]");
 	CHECK(firstMatrix.toString() == "[[x,5,7][1,y,2][z,4,6]]");
@@ -188,12 +684,12 @@ TEST_CASE("SymbolicSquareMatrix correct tests", "Symbolicmatrix_correct"){
 	SymbolicSquareMatrix mathMatrixTwo("[[3,1,4][5,2,4][7,2,6]]");
 
 	SymbolicSquareMatrix addition = mathMatrix + mathMatrixTwo;
-	CHECK(addition.toString() == "[[(x+3),(5+1),(7+4)][(1+5),(y+2),(2+4)][(z+7),(4+2),(6+6)]]");
+	CHECK(addition.toString() == "[[(x+3),6,11][6,(y+2),6][(z+7),6,12]]");
 	ConcreteSquareMatrix solvedAddition = addition.evaluate(valu);
 	CHECK(solvedAddition.toString() == "[[6,6,11][6,4,6][11,6,12]]");
 	
 	SymbolicSquareMatrix subtraction = mathMatrix - mathMatrixTwo;
-	CHECK(subtraction.toString() == "[[(x-3),(5-1),(7-4)][(1-5),(y-2),(2-4)][(z-7),(4-2),(6-6)]]");
+	CHECK(subtraction.toString() == "[[(x-3),4,3][-4,(y-2),-2][(z-7),2,0]]");
 	ConcreteSquareMatrix solvedSubtraction = subtraction.evaluate(valu);
 	CHECK(solvedSubtraction.toString() == "[[0,4,3][-4,0,-2][-3,2,0]]");
 
@@ -203,6 +699,524 @@ TEST_CASE("SymbolicSquareMatrix correct tests", "Symbolicmatrix_correct"){
 
 }
 
+TEST_CASE("SymbolicSquareMatrix rvalue operator tests", "symbolicmatrix_rvalue"){
+	SymbolicSquareMatrix a("[[x,1][2,y]]");
+	SymbolicSquareMatrix b("[[3,z][y,4]]");
+	Valuation valu;
+	valu['x'] = 2;
+	valu['y'] = -1;
+	valu['z'] = 5;
+
+	CHECK((SymbolicSquareMatrix(a) + b).toString() == (a + b).toString());
+	CHECK((SymbolicSquareMatrix(a) - b).toString() == (a - b).toString());
+	CHECK((SymbolicSquareMatrix(a) * b).toString() == (a * b).toString());
+	CHECK(((a + b) + a).toString() == "[[((x+3)+x),((1+z)+1)][((2+y)+2),((y+4)+y)]]");
+	CHECK((a * b * a).evaluate(valu) == a.evaluate(valu) * b.evaluate(valu) * a.evaluate(valu));
+
+	SymbolicSquareMatrix self(a);
+	SymbolicSquareMatrix doubled = std::move(self) + self;
+	CHECK(doubled.toString() == "[[(2*x),2][4,(2*y)]]");
+
+	SymbolicSquareMatrix other("[[1]]");
+	CHECK_THROWS_AS(SymbolicSquareMatrix(a) * other, std::domain_error);
+}
+
+TEST_CASE("Matrix power tests", "matrix_pow"){
+	ConcreteSquareMatrix fibonacci("[[1,1][1,0]]");
+	CHECK(fibonacci.pow(0).toString() == "[[1,0][0,1]]");
+	CHECK(fibonacci.pow(1) == fibonacci);
+	CHECK(fibonacci.pow(10).toString() == "[[89,55][55,34]]");
+	CHECK(Concrete64SquareMatrix(fibonacci).pow(90).getVal(0, 1) == 2880067194370816120);
+	CHECK_THROWS_AS(fibonacci.pow(-1), std::invalid_argument);
+
+	ConcreteSquareMatrix a = patternMatrix(19, 31);
+	ConcreteSquareMatrix expected = a;
+	for (int k = 2; k <= 13; ++k){
+		expected = expected * a;
+		CHECK(a.pow(k) == expected);
+	}
+
+	SymbolicSquareMatrix s("[[x,1][0,y]]");
+	Valuation valu;
+	valu['x'] = 3;
+	valu['y'] = -2;
+	CHECK(s.pow(0).toString() == "[[1,0][0,1]]");
+	CHECK(s.pow(1).toString() == s.toString());
+	CHECK(s.pow(2).toString() == (s*s).toString());
+	CHECK(s.pow(7).evaluate(valu) == s.evaluate(valu).pow(7));
+	CHECK(s.pow(40).evaluate(valu) == s.evaluate(valu).pow(40));
+	CHECK_THROWS_AS(s.pow(-2), std::invalid_argument);
+}
+
+TEST_CASE("NodeArena tests", "nodearena"){
+	NodeArena arena;
+	void* first = arena.allocate(24, 8);
+	void* second = arena.allocate(1, 1);
+	void* third = arena.allocate(16, 16);
+	CHECK(arena.getAllocationCount() == 3);
+	CHECK(arena.getChunkCount() == 1);
+	// small requests are rounded up to their size class
+	CHECK(static_cast<char*>(second) == static_cast<char*>(first) + 2*alignof(std::max_align_t));
+	CHECK(reinterpret_cast<std::uintptr_t>(third) % 16 == 0);
+	void* large = arena.allocate(1 << 20, 8);
+	CHECK(arena.getChunkCount() == 1);
+	const std::size_t used = arena.getBytesUsed();
+	arena.deallocate(first, 24);
+	CHECK(arena.getBytesUsed() == used - 2*alignof(std::max_align_t));
+	CHECK(arena.allocate(20, 8) == first);
+	CHECK(arena.getBytesUsed() == used);
+	arena.deallocate(large, 1 << 20);
+	CHECK(arena.getBytesUsed() == used - (1 << 20));
+
+	// the node and its reference counts are one block, freed with the last weak reference
+	const std::size_t before = arena.getBytesUsed();
+	std::shared_ptr<IntElement> node = makeArenaNode<IntElement>(arena, 5);
+	CHECK(node->getVal() == 5);
+	CHECK(arena.getBytesUsed() > before);
+	const std::size_t withNode = arena.getBytesUsed();
+	std::weak_ptr<IntElement> watcher = node;
+	node.reset();
+	CHECK(arena.getBytesUsed() == withNode);
+	watcher.reset();
+	CHECK(arena.getBytesUsed() == before);
+}
+
+TEST_CASE("ElementPool hash-consing tests", "elementpool"){
+	ElementPool& pool = ElementPool::global();
+	std::size_t misses = pool.getMissCount();
+	SymbolicSquareMatrix a("[[x,y][y,x]]");
+	CHECK(pool.getMissCount() - misses == 2);
+	misses = pool.getMissCount();
+	SymbolicSquareMatrix b("[[x,2][2,y]]");
+	CHECK(&a.getElement(0, 0) == &a.getElement(1, 1));
+	CHECK(&a.getElement(0, 0) == &b.getElement(0, 0));
+	CHECK(pool.getMissCount() - misses == 1);
+
+	SymbolicSquareMatrix first = a * b;
+	std::size_t hits = pool.getHitCount();
+	misses = pool.getMissCount();
+	SymbolicSquareMatrix second = a * b;
+	CHECK(pool.getHitCount() - hits == 4*3);
+	CHECK(pool.getMissCount() == misses);
+	for (int i = 0; i < 2; ++i){
+		for (int j = 0; j < 2; ++j){
+			CHECK(&first.getElement(i, j) == &second.getElement(i, j));
+		}
+	}
+
+	SymbolicSquareMatrix same("[[x,x][x,x]]");
+	misses = pool.getMissCount();
+	SymbolicSquareMatrix square = same * same;
+	CHECK(&square.getElement(0, 0) == &square.getElement(1, 1));
+	// x*x is already pooled from a*b, only (x*x)+(x*x) is new
+	CHECK(pool.getMissCount() - misses == 1);
+
+	std::size_t live = ElementPool::global().getLiveCount();
+	{
+		SymbolicSquareMatrix big = square.pow(8);
+		CHECK(big.toString() == SymbolicSquareMatrix(big).toString());
+		CHECK(pool.getLiveCount() > live);
+	}
+	CHECK(pool.getLiveCount() == live);
+
+	// no zeros, ones or like terms, so simplification leaves every node of the operations in place
+	misses = pool.getMissCount();
+	SymbolicSquareMatrix c("[[x,2,3][y,4,5][6,z,7]]");
+	// x, y and 2 are still live in a and b
+	CHECK(pool.getMissCount() - misses == 6);
+	SymbolicSquareMatrix d("[[p,q,r][s,t,u][v,w,x]]");
+	misses = pool.getMissCount();
+	SymbolicSquareMatrix sum = c + d;
+	CHECK(pool.getMissCount() - misses == 9);
+	misses = pool.getMissCount();
+	SymbolicSquareMatrix product = c * d;
+	CHECK(pool.getMissCount() - misses == 9*(2*3 - 1));
+
+	Valuation valu;
+	valu['x'] = 1;
+	valu['y'] = 2;
+	valu['z'] = 3;
+	for (char v = 'p'; v <= 'w'; ++v)
+		valu[v] = v - 'p' + 4;
+	ConcreteSquareMatrix expected = c.evaluate(valu) * d.evaluate(valu);
+	c = SymbolicSquareMatrix();
+	d = SymbolicSquareMatrix();
+	CHECK(product.evaluate(valu) == expected);
+
+	// a node shared by a small matrix keeps only itself alive, not the rest of the big matrix it came from
+	std::string rows = "[";
+	for (int i = 0; i < 12; ++i){
+		rows += "[";
+		for (int j = 0; j < 12; ++j){
+			if(j > 0)
+				rows += ",";
+			rows += (i*12 + j) % 3 == 0 ? std::string(1, static_cast<char>('a' + (i*5 + j) % 26)) : std::to_string(i*12 + j + 2);
+		}
+		rows += "]";
+	}
+	rows += "]";
+	const std::size_t bytes = pool.getBytesUsed();
+	live = pool.getLiveCount();
+	SymbolicSquareMatrix small;
+	std::size_t peak;
+	{
+		SymbolicSquareMatrix big = SymbolicSquareMatrix(rows) * SymbolicSquareMatrix(rows);
+		peak = pool.getBytesUsed();
+		misses = pool.getMissCount();
+		small = SymbolicSquareMatrix("[[a]]") * SymbolicSquareMatrix("[[a]]");
+		CHECK(pool.getMissCount() == misses);
+	}
+	CHECK(pool.getBytesUsed() < peak);
+	CHECK(pool.getLiveCount() == live + 2);
+	// two blocks of node and reference counts are left
+	CHECK(pool.getBytesUsed() > bytes + sizeof(VariableElement) + sizeof(CompositeElement));
+	CHECK(pool.getBytesUsed() < bytes + 512);
+	Valuation one;
+	one['a'] = 3;
+	CHECK(small.evaluate(one) == ConcreteSquareMatrix("[[9]]"));
+}
+
+TEST_CASE("Symbolic simplification tests", "symbolicmatrix_simplify"){
+	SymbolicSquareMatrix sparse("[[x,0,0][0,1,y][0,0,2]]");
+	SymbolicSquareMatrix other("[[1,z,0][0,x,0][3,0,1]]");
+	SymbolicSquareMatrix product = sparse * other;
+	CHECK(product.toString() == "[[x,(x*z),0][(3*y),x,y][6,0,2]]");
+	CHECK((sparse - sparse).toString() == "[[0,0,0][0,0,0][0,0,0]]");
+	CHECK((sparse + sparse + sparse).toString() == "[[(3*x),0,0][0,3,(3*y)][0,0,6]]");
+	CHECK((sparse + sparse - sparse).toString() == sparse.toString());
+
+	SymbolicSquareMatrix shifted("[[x,4][5,2]]");
+	SymbolicSquareMatrix constant("[[3,1][0,7]]");
+	CHECK((shifted + constant + constant).toString() == "[[(x+6),6][5,16]]");
+	CHECK((shifted + constant - constant).toString() == "[[x,4][5,2]]");
+
+	Valuation valu;
+	valu['x'] = 2147483647;
+	valu['y'] = -5;
+	valu['z'] = 9;
+	ElementPool::global().setSimplifying(false);
+	SymbolicSquareMatrix literal = (sparse * other).pow(2) - sparse;
+	ElementPool::global().setSimplifying(true);
+	CHECK(ElementPool::global().isSimplifying());
+	SymbolicSquareMatrix simplified = literal.simplify();
+	CHECK(simplified.toString() == (product.pow(2) - sparse).toString());
+	CHECK(simplified.evaluate(valu) == literal.evaluate(valu));
+	CHECK(simplified.toString().size()*5 < literal.toString().size());
+	CHECK(simplified.compile().getInstructionCount() < literal.compile().getInstructionCount());
+
+	SymbolicSquareMatrix cancelled = (SymbolicSquareMatrix("[[x,y][1,2]]") - SymbolicSquareMatrix("[[x,0][1,2]]"));
+	// x cancels while the operator builds the matrix, every evaluation method agrees it is not needed
+	CHECK(cancelled.getVariables().count() == 1);
+	CHECK(cancelled.evaluateTrees(Valuation{{'y', 4}}) == cancelled.evaluate(Valuation{{'y', 4}}));
+	CHECK(evaluateFixed<2>(cancelled, Valuation{{'y', 4}}).toConcrete() == cancelled.evaluate(Valuation{{'y', 4}}));
+	CHECK(cancelled.simplify().getVariables().count() == 1);
+
+	// x is only multiplied by zero, the product and its in-place form both drop it from the set
+	const SymbolicSquareMatrix selector("[[0,0][1,1]]");
+	const SymbolicSquareMatrix rows("[[x,y][0,0]]");
+	CHECK((rows*selector).getVariables().count() == 1);
+	CHECK((rows*selector).getVariables().test('y'));
+	CHECK((SymbolicSquareMatrix(rows)*selector).getVariables() == (rows*selector).getVariables());
+	CHECK((rows*selector).evaluateTrees(Valuation{{'y', 3}}).toString() == "[[3,3][0,0]]");
+	CHECK(rows.partialEvaluate(Valuation{{'y', 3}}).getVariables().test('x'));
+	CHECK((rows + rows).getVariables().count() == 2);
+	CHECK(cancelled.simplify().evaluate(Valuation{{'y', 4}}).toString() == "[[0,4][0,0]]");
+}
+
+TEST_CASE("Partial evaluation tests", "symbolicmatrix_partial"){
+	SymbolicSquareMatrix a("[[x,y][1,z]]");
+	SymbolicSquareMatrix b("[[y,2][x,0]]");
+	SymbolicSquareMatrix full = (a * b).pow(2) - a;
+
+	Valuation outer;
+	outer['x'] = 0;
+	outer['y'] = 3;
+	SymbolicSquareMatrix reduced = full.partialEvaluate(outer);
+	CHECK(reduced.getVariables().count() == 1);
+	CHECK(reduced.getVariables().test('z'));
+	CHECK(reduced.compile().getInstructionCount() < full.compile().getInstructionCount());
+	CHECK(reduced.compile().getDistinctNodeCount()*2 < full.compile().getDistinctNodeCount());
+
+	Valuation valu(outer);
+	for (int z : {-4, 0, 5, 2147483647}){
+		valu['z'] = z;
+		Valuation inner;
+		inner['z'] = z;
+		CHECK(reduced.evaluate(inner) == full.evaluateTrees(valu));
+	}
+
+	CHECK(full.partialEvaluate(Valuation()).toString() == full.toString());
+	CHECK(full.partialEvaluate(valu).getVariables().none());
+	CHECK(full.partialEvaluate(valu).evaluate(Valuation()) == full.evaluate(valu));
+	CHECK(SymbolicSquareMatrix("[[x,y][x,1]]").partialEvaluate(Valuation{{'x', 2}, {'w', 9}}).toString() == "[[2,y][2,1]]");
+	CHECK_THROWS_AS(reduced.evaluate(outer), std::out_of_range);
+}
+
+TEST_CASE("SymbolicSquareMatrix variable tracking tests", "symbolicmatrix_variables"){
+	SymbolicSquareMatrix first("[[x,1][y,2]]");
+	SymbolicSquareMatrix second("[[3,z][4,x]]");
+	CHECK(first.getVariables().count() == 2);
+	CHECK(first.getVariables().test('x'));
+	CHECK(first.getVariables().test('y'));
+	CHECK(SymbolicSquareMatrix("[[1,2][3,4]]").getVariables().none());
+
+	CHECK((first + second).getVariables().count() == 3);
+	CHECK((first - second).getVariables().test('z'));
+	CHECK((first * second).getVariables().count() == 3);
+	CHECK(first.transpose().getVariables() == first.getVariables());
+	CHECK(first.pow(3).getVariables() == first.getVariables());
+	CHECK(first.pow(0).getVariables().none());
+	SymbolicSquareMatrix moved(first);
+	moved = std::move(moved) * second;
+	CHECK(moved.getVariables().count() == 3);
+	SymbolicSquareMatrix copy;
+	copy = second;
+	CHECK(copy.getVariables() == second.getVariables());
+
+	Valuation valu;
+	valu['y'] = 1;
+	SymbolicSquareMatrix product = first * second;
+	try{
+		product.evaluate(valu);
+		FAIL("Missing variables not reported");
+	}catch(const std::out_of_range& e){
+		CHECK(std::string(e.what()) == "Out of range, values not mapped: x z");
+	}
+	CHECK_THROWS_WITH(product.compile().evaluate(valu), "Out of range, values not mapped: x z");
+	CHECK_THROWS_WITH(evaluateFixed<2>(product, valu), "Out of range, values not mapped: x z");
+	CHECK_THROWS_WITH(product.evaluateBatch(ValuationBatch{{'y', {1, 2}}}), "Out of range, values not mapped: x z");
+	valu['x'] = 2;
+	valu['z'] = 3;
+	CHECK_NOTHROW(product.evaluate(valu));
+}
+
+TEST_CASE("CompiledMatrix tests", "compiledmatrix"){
+	Valuation valu;
+	valu['x'] = 3;
+	valu['y'] = -7;
+	valu['z'] = 11;
+
+	SymbolicSquareMatrix first("[[x,2,y][z,x,5][1,y,z]]");
+	SymbolicSquareMatrix second("[[y,x,4][-2,z,x][x,1,y]]");
+	SymbolicSquareMatrix expression = (first * second - first).pow(3) + second;
+	CompiledMatrix compiled = expression.compile();
+	CHECK(compiled.getSize() == 3);
+	CHECK(compiled.getVariables().size() == 3);
+	CHECK(compiled.evaluate(valu) == expression.evaluateTrees(valu));
+	valu['x'] = 2147483647;
+	CHECK(compiled.evaluate(valu) == expression.evaluateTrees(valu));
+
+	SymbolicSquareMatrix same("[[x,x][x,x]]");
+	CompiledMatrix shared = (same * same).compile();
+	CHECK(shared.getInstructionCount() == 2);
+	CHECK(shared.evaluate(valu) == (same * same).evaluateTrees(valu));
+
+	SymbolicSquareMatrix constants("[[1,2][3,4]]");
+	CompiledMatrix folded = (constants * constants).compile();
+	CHECK(folded.getInstructionCount() == 0);
+	CHECK(folded.getVariables().empty());
+	CHECK(folded.evaluate(Valuation()).toString() == "[[7,10][15,22]]");
+
+	CHECK(CompiledMatrix().evaluate(Valuation()).getSize() == 0);
+	Valuation partial;
+	partial['x'] = 1;
+	CHECK_THROWS_AS(compiled.evaluate(partial), std::out_of_range);
+}
+
+TEST_CASE("Common subexpression tests", "compiledmatrix_cse"){
+	SymbolicSquareMatrix a("[[a,b][c,d]]");
+	SymbolicSquareMatrix square = a * a;
+	CompiledMatrix compiled = square.compile();
+	// 4 leaves, 8 distinct products, 4 sums, the products b*c and c*b are different nodes
+	CHECK(compiled.getDistinctNodeCount() == 4 + 8 + 4);
+	CHECK(compiled.getTreeNodeCount() == 4*7);
+	CHECK(compiled.getEliminatedCount() == 4*7 - 16);
+
+	SymbolicSquareMatrix big = square.pow(16);
+	CompiledMatrix bigCompiled = big.compile();
+	CHECK(bigCompiled.getTreeNodeCount() > 100*bigCompiled.getDistinctNodeCount());
+	CHECK(bigCompiled.getInstructionCount() < bigCompiled.getDistinctNodeCount());
+
+	Valuation valu;
+	valu['a'] = 1;
+	valu['b'] = 2;
+	valu['c'] = -1;
+	valu['d'] = 3;
+	CHECK(big.evaluate(valu) == big.evaluateTrees(valu));
+	CHECK(square.evaluate(valu).toString() == "[[-1,8][-4,7]]");
+
+	std::shared_ptr<const CompiledMatrix> program = square.getProgram();
+	CHECK(square.getProgram() == program);
+	SymbolicSquareMatrix copy(square);
+	CHECK(copy.getProgram() == program);
+	SymbolicSquareMatrix sum = std::move(copy) + a;
+	CHECK(sum.getProgram() != program);
+	CHECK(sum.evaluate(valu) == sum.evaluateTrees(valu));
+	SymbolicSquareMatrix transposed = SymbolicSquareMatrix(square).transpose();
+	CHECK(transposed.evaluate(valu).toString() == "[[-1,-4][8,7]]");
+	CHECK_THROWS_AS(square.evaluateTrees(Valuation()), std::out_of_range);
+}
+
+TEST_CASE("EvaluatedMatrix incremental update tests", "evaluatedmatrix"){
+	// every variable appears in one row only, so it reaches one row of the product with a constant matrix
+	SymbolicSquareMatrix a("[[a,1,0,2][0,b,3,0][4,0,c,0][0,5,0,d]]");
+	SymbolicSquareMatrix b("[[1,2,0,0][0,1,2,0][0,0,1,2][2,0,0,1]]");
+	SymbolicSquareMatrix product = a * b + b;
+
+	Valuation valu;
+	valu['a'] = 1;
+	valu['b'] = 2;
+	valu['c'] = 3;
+	valu['d'] = 4;
+	EvaluatedMatrix evaluated(product, valu);
+	CHECK(evaluated.getResult() == product.evaluateTrees(valu));
+	CHECK(evaluated.getProgram() == product.getProgram());
+
+	valu['b'] = -7;
+	evaluated.set('b', -7);
+	CHECK(evaluated.getResult() == product.evaluateTrees(valu));
+	CHECK(evaluated.getLastUpdateCount() > 0);
+	CHECK(evaluated.getLastUpdateCount()*2 <= product.compile().getInstructionCount());
+
+	evaluated.set('b', -7);
+	CHECK(evaluated.getLastUpdateCount() == 0);
+	evaluated.set('q', 1);
+	CHECK(evaluated.getLastUpdateCount() == 0);
+
+	valu['a'] = 2147483647;
+	valu['d'] = 9;
+	evaluated.update(valu);
+	CHECK(evaluated.getResult() == product.evaluateTrees(valu));
+	valu['c'] = 0;
+	evaluated.update(valu);
+	CHECK(evaluated.getResult() == product.evaluateTrees(valu));
+
+	valu.erase('c');
+	CHECK_THROWS_WITH(evaluated.update(valu), "Out of range, values not mapped: c");
+	CHECK_THROWS_AS(EvaluatedMatrix(product, valu), std::out_of_range);
+	CHECK(EvaluatedMatrix(SymbolicSquareMatrix("[[1,2][3,4]]"), Valuation()).getResult().toString() == "[[1,2][3,4]]");
+}
+
+TEST_CASE("EvaluationCache tests", "evaluationcache"){
+	SymbolicSquareMatrix m("[[x,1][y,x]]");
+	SymbolicSquareMatrix square = m * m;
+	CHECK(square.getCache() == nullptr);
+	square.enableCache(1 << 20);
+	REQUIRE(square.getCache() != nullptr);
+	const EvaluationCache& cache = *square.getCache();
+
+	// an identical matrix shares every node, assigning it still takes over the cache
+	SymbolicSquareMatrix same = m * m;
+	same = square;
+	CHECK(same.getCache() == square.getCache());
+	SymbolicSquareMatrix moved = m * m;
+	moved = SymbolicSquareMatrix(square);
+	CHECK(moved.getCache() == square.getCache());
+
+	Valuation valu;
+	valu['x'] = 2;
+	valu['y'] = 3;
+	ConcreteSquareMatrix first = square.evaluate(valu);
+	CHECK(first == square.evaluateTrees(valu));
+	CHECK(cache.getMissCount() == 1);
+	CHECK(square.evaluate(valu) == first);
+	CHECK(cache.getHitCount() == 1);
+	// z is not in the matrix, so it is not part of the key
+	valu['z'] = 7;
+	CHECK(square.evaluate(valu) == first);
+	CHECK(cache.getHitCount() == 2);
+	CHECK(cache.getEntryCount() == 1);
+
+	SymbolicSquareMatrix copy(square);
+	CHECK(copy.getCache() == &cache);
+	CHECK(copy.evaluate(valu) == first);
+	CHECK(cache.getHitCount() == 3);
+	CHECK((std::move(copy) + m).getCache() == nullptr);
+	CHECK((square + m).getCache() == nullptr);
+
+	valu.erase('y');
+	CHECK_THROWS_AS(square.evaluate(valu), std::out_of_range);
+	CHECK(cache.getMissCount() == 1);
+
+	valu['y'] = 0;
+	square.evaluate(valu);
+	const std::size_t entryBytes = cache.getBytesUsed() / 2;
+	CHECK(cache.getEntryCount() == 2);
+	CHECK(entryBytes*2 == cache.getBytesUsed());
+
+	SymbolicSquareMatrix small(square);
+	small.enableCache(3*entryBytes);
+	CHECK(small.getCache() != square.getCache());
+	for (int v = 0; v < 4; ++v){
+		valu['x'] = v;
+		CHECK(small.evaluate(valu) == square.evaluateTrees(valu));
+	}
+	CHECK(small.getCache()->getEntryCount() == 3);
+	CHECK(small.getCache()->getEvictionCount() == 1);
+	CHECK(small.getCache()->getBytesUsed() <= small.getCache()->getCapacity());
+	valu['x'] = 3;
+	small.evaluate(valu);
+	valu['x'] = 1;
+	small.evaluate(valu);
+	CHECK(small.getCache()->getHitCount() == 2);
+	valu['x'] = 0;
+	small.evaluate(valu);
+	CHECK(small.getCache()->getMissCount() == 5);
+
+	small.disableCache();
+	CHECK(small.getCache() == nullptr);
+	SymbolicSquareMatrix tiny(square);
+	tiny.enableCache(1);
+	CHECK(tiny.evaluate(valu) == square.evaluateTrees(valu));
+	CHECK(tiny.getCache()->getEntryCount() == 0);
+}
+
+TEST_CASE("Batch evaluation tests", "compiledmatrix_batch"){
+	SymbolicSquareMatrix first("[[x,2,y][z,x,5][1,y,z]]");
+	SymbolicSquareMatrix expression = (first * first.transpose() - first).pow(2);
+
+	ValuationBatch batch;
+	const int count = 3*static_cast<int>(CompiledMatrix::BATCH_BLOCK) + 5;
+	for (int b = 0; b < count; ++b){
+		batch['x'].push_back(b - 100);
+		batch['y'].push_back(3*b + 1);
+		batch['z'].push_back(b % 7 == 0 ? 2147483647 : -b);
+	}
+
+	std::vector<ConcreteSquareMatrix> results = expression.evaluateBatch(batch);
+	REQUIRE(results.size() == static_cast<std::size_t>(count));
+	bool allEqual = true;
+	for (int b = 0; b < count; ++b){
+		Valuation valu;
+		valu['x'] = batch['x'][b];
+		valu['y'] = batch['y'][b];
+		valu['z'] = batch['z'][b];
+		allEqual = allEqual && results[b] == expression.evaluateTrees(valu);
+	}
+	CHECK(allEqual);
+
+	CompiledMatrix compiled = expression.compile();
+	std::vector<int> tensor(9*2);
+	std::vector<int> values{1, 2, 3, 4, 5, 6};
+	compiled.evaluateBatch(2, values.data(), tensor.data());
+	Valuation second;
+	for (std::size_t v = 0; v < compiled.getVariables().size(); ++v)
+		second[compiled.getVariables()[v]] = values[v*2 + 1];
+	CHECK(std::equal(tensor.begin() + 9, tensor.end(), compiled.evaluate(second).data()));
+
+	CHECK(SymbolicSquareMatrix("[[1,2][3,4]]").evaluateBatch(batch).size() == static_cast<std::size_t>(count));
+	CHECK_THROWS_AS(SymbolicSquareMatrix("[[1,2][3,4]]").evaluateBatch(ValuationBatch()), std::invalid_argument);
+	batch['w'].push_back(1);
+	CHECK_THROWS_WITH(expression.evaluateBatch(batch), "Valuations of different lengths");
+	CHECK_THROWS_WITH(SymbolicSquareMatrix("[[1,2][3,4]]").evaluateBatch(batch), "Valuations of different lengths");
+	batch.erase('w');
+	CHECK(expression.evaluateBatch(ValuationBatch{{'x', {}}, {'y', {}}, {'z', {}}}).empty());
+	batch['z'].pop_back();
+	CHECK_THROWS_AS(expression.evaluateBatch(batch), std::invalid_argument);
+	batch.erase('z');
+	CHECK_THROWS_AS(expression.evaluateBatch(batch), std::out_of_range);
+}
+
 TEST_CASE("SymbolicSquareMatrix incorrect tests and exceptions", "symbolicmatrix_incorrect"){
 	CHECK_NOTHROW(SymbolicSquareMatrix("[]"));
 	CHECK_NOTHROW(SymbolicSquareMatrix("[[1]]"));
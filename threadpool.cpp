@@ -0,0 +1,131 @@
+/**
+	\file threadpool.cpp
+	\brief Code for ThreadPool class
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(int threads):stopping{false}{
+	start(threads);
+}
+
+ThreadPool::~ThreadPool(){
+	stop();
+}
+
+void ThreadPool::start(int threads){
+	stopping = false;
+	for (int i = 1; i < threads; ++i){
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+void ThreadPool::stop(){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	available.notify_all();
+	for (auto& worker : workers){
+		worker.join();
+	}
+	workers.clear();
+}
+
+void ThreadPool::workerLoop(){
+	for(;;){
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			available.wait(lock, [this]{ return stopping || !jobs.empty(); });
+			if(jobs.empty())
+				return;
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
+
+int ThreadPool::getThreadCount() const{
+	return static_cast<int>(workers.size()) + 1;
+}
+
+void ThreadPool::resize(int threads){
+	stop();
+	start(threads);
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& task){
+	if(count <= 0)
+		return;
+
+	struct State{
+		std::function<void(int)> task;
+		int count;
+		std::atomic<int> next{0};
+		std::atomic<int> done{0};
+		std::mutex mutex;
+		std::condition_variable finished;
+		std::exception_ptr error;
+	};
+	auto state = std::make_shared<State>();
+	state->task = task;
+	state->count = count;
+
+	auto run = [state]{
+		for(;;){
+			int i = state->next.fetch_add(1);
+			if(i >= state->count)
+				return;
+			try{
+				state->task(i);
+			}catch(...){
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if(!state->error)
+					state->error = std::current_exception();
+			}
+			if(state->done.fetch_add(1) + 1 == state->count){
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->finished.notify_all();
+			}
+		}
+	};
+
+	int helpers = std::min(count - 1, static_cast<int>(workers.size()));
+	if(helpers > 0){
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (int i = 0; i < helpers; ++i){
+				jobs.emplace_back(run);
+			}
+		}
+		available.notify_all();
+	}
+
+	run();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&state]{ return state->done.load() == state->count; });
+	if(state->error)
+		std::rethrow_exception(state->error);
+}
+
+ThreadPool& ThreadPool::global(){
+	static ThreadPool pool(defaultThreadCount());
+	return pool;
+}
+
+int ThreadPool::defaultThreadCount(){
+	if(const char* env = std::getenv("MATRIX_THREADS")){
+		int threads = std::atoi(env);
+		if(threads > 0)
+			return threads;
+	}
+	return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
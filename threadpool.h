@@ -0,0 +1,101 @@
+/**
+	\file threadpool.h
+	\brief Header for ThreadPool class
+*/
+
+#ifndef THREADPOOL_H_INCLUDED
+#define THREADPOOL_H_INCLUDED
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+	\class ThreadPool
+	\brief Fixed set of worker threads, used to split matrix kernels into parallel tasks
+*/
+class ThreadPool{
+
+private:
+	/**
+		\brief Worker threads, the thread calling parallelFor works as one more
+	*/
+	std::vector<std::thread> workers;
+	/**
+		\brief Jobs waiting for a free worker
+	*/
+	std::deque<std::function<void()>> jobs;
+	/**
+		\brief Guards jobs and stopping
+	*/
+	std::mutex mutex;
+	/**
+		\brief Signalled when a job is queued or the pool is stopping
+	*/
+	std::condition_variable available;
+	/**
+		\brief Set when workers should exit once the queue is empty
+	*/
+	bool stopping;
+
+	/**
+		\brief Loop run by every worker thread
+	*/
+	void workerLoop();
+	/**
+		\brief Starts threads-1 workers
+		\param Total number of threads
+	*/
+	void start(int threads);
+	/**
+		\brief Finishes queued jobs and joins all workers
+	*/
+	void stop();
+
+public:
+	/**
+		\brief Parametric constructor
+		\param Total number of threads including the calling thread, at least 1
+	*/
+	explicit ThreadPool(int threads);
+	/**
+		\brief Destructor, joins all workers
+	*/
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+		\brief Method to get the number of threads work is split across
+		\return Worker count plus the calling thread
+	*/
+	int getThreadCount() const;
+	/**
+		\brief Changes the number of threads, must not be called while parallelFor is running
+		\param Total number of threads including the calling thread, at least 1
+	*/
+	void resize(int threads);
+	/**
+		\brief Runs task(0) ... task(count-1) across the pool and waits for all of them
+		\param Number of tasks
+		\param Task to run, called concurrently with different indices
+		\throw Rethrows the first exception thrown by a task
+	*/
+	void parallelFor(int count, const std::function<void(int)>& task);
+
+	/**
+		\brief Process-wide pool used by the matrix kernels
+		\return Pool sized by defaultThreadCount() on first use
+	*/
+	static ThreadPool& global();
+	/**
+		\brief Thread count from the MATRIX_THREADS environment variable, or the hardware concurrency
+		\return Number of threads, at least 1
+	*/
+	static int defaultThreadCount();
+};
+
+#endif // THREADPOOL_H_INCLUDED
@@ -5,11 +5,136 @@
 
 #ifndef VALUATION_H_INCLUDED
 #define VALUATION_H_INCLUDED
+#include <array>
+#include <bitset>
 #include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 /**
 	\brief Assigning map to Valuation for readability
 */
 using Valuation = std::map<char,int>;
 
+/**
+	\brief Many valuations stored structure of arrays, entry b of every vector is valuation b
+*/
+using ValuationBatch = std::map<char,std::vector<int>>;
+
+/**
+	\class DenseValuation
+	\brief Valuation indexed directly by variable name, looking up a variable is one indexed load
+
+	Taken by every evaluate method. A Valuation map converts to it implicitly, so evaluating with
+	a map converts it once per call instead of searching the map once per variable occurrence.
+*/
+class DenseValuation{
+
+private:
+	/**
+		\brief Value of every possible variable name, 0 when not mapped
+	*/
+	std::array<int, 256> values;
+	/**
+		\brief Set bit for every mapped variable name
+	*/
+	std::bitset<256> present;
+
+	/**
+		\brief Index of a variable name
+	*/
+	static constexpr std::size_t index(char name){
+		return static_cast<unsigned char>(name);
+	}
+
+public:
+	/**
+		\brief Empty constructor, no variable is mapped
+	*/
+	constexpr DenseValuation():values{},present{}{}
+
+	/**
+		\brief Converting constructor
+		\param Valuation map to copy
+	*/
+	DenseValuation(const Valuation& val):DenseValuation(){
+		for (const auto& entry : val)
+			set(entry.first, entry.second);
+	}
+
+	/**
+		\brief Maps a variable
+		\param Variable name
+		\param Value
+	*/
+	void set(char name, int value){
+		values[index(name)] = value;
+		present.set(index(name));
+	}
+
+	/**
+		\brief Unmaps a variable
+		\param Variable name
+	*/
+	void erase(char name){
+		values[index(name)] = 0;
+		present.reset(index(name));
+	}
+
+	/**
+		\brief Method to check if a variable is mapped
+		\param Variable name
+		\return Boolean, true if mapped
+	*/
+	bool contains(char name) const{
+		return present.test(index(name));
+	}
+
+	/**
+		\brief Unchecked lookup
+		\param Variable name
+		\return Value, 0 if not mapped
+	*/
+	int operator[](char name) const{
+		return values[index(name)];
+	}
+
+	/**
+		\brief Checked lookup
+		\param Variable name
+		\return Value
+		\throw std::out_of_range if the variable is not mapped
+	*/
+	int at(char name) const{
+		if(!contains(name))
+			throw std::out_of_range("Variable not mapped");
+		return values[index(name)];
+	}
+
+	/**
+		\brief Method to get the set of mapped variables
+		\return Bit c is set if variable c is mapped
+	*/
+	const std::bitset<256>& getPresent() const{
+		return present;
+	}
+};
+
+/**
+	\brief Error message for variables missing from a valuation
+	\param Set bit for every missing variable name
+	\return Message listing the names in order
+*/
+inline std::string unmappedMessage(const std::bitset<256>& missing){
+	std::string message = "Out of range, values not mapped:";
+	for (std::size_t c = 0; c < missing.size(); ++c){
+		if(missing.test(c)){
+			message += ' ';
+			message += static_cast<char>(c);
+		}
+	}
+	return message;
+}
+
 #endif
\ No newline at end of file